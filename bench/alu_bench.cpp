@@ -0,0 +1,183 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+#include "../src/flags.hpp"
+
+// Compares the old bit-by-bit parity loop against the SZP table for the flags of ADD, SUB, ANA and CMP
+// The table versions are the bodies of I8080::add, sub, ana and cmp, with the flags packed into a Flags byte
+// Run with `make alu-bench && ./alu-bench`
+
+#define ITERATIONS 50000000
+#define OPERANDS 4096 // Must be a power of two
+
+// Flags as run_opcode used to keep them, one field per flag
+struct Unpacked
+{
+    uint8_t a;
+    uint8_t s, z, p, c;
+
+    uint32_t szpc() const { return s << 7 | z << 6 | p << 2 | c; }
+};
+
+// Flags as I8080 keeps them now
+struct Packed
+{
+    uint8_t a;
+    Flags flags;
+
+    uint32_t szpc() const { return flags.psw & (FLAG_S | FLAG_Z | FLAG_P | FLAG_C); }
+};
+
+// How run_opcode used to work out the parity of a result
+static bool parity(int x, int size)
+{
+    int i;
+    int p = 0;
+    x = (x & ((1 << size) - 1));
+    for (i = 0; i < size; ++i)
+    {
+        if (x & 0x1) p++;
+        x >>= 1;
+    }
+    return (p & 0x1) == 0;
+}
+
+static void add_loop(Unpacked& st, uint8_t value)
+{
+    uint16_t ans = (uint16_t) st.a + (uint16_t) value;
+    st.z = (ans & 0xFF) == 0;
+    st.s = (ans & 0x80) == 0x80;
+    st.c = ans > 0xFF;
+    st.p = parity((ans & 0xFF), 8);
+    st.a = (uint8_t) ans;
+}
+
+static void sub_loop(Unpacked& st, uint8_t value)
+{
+    uint16_t ans = (uint16_t) st.a - (uint16_t) value;
+    st.z = (ans & 0xFF) == 0;
+    st.s = (0x80 == (ans & 0x80));
+    st.c = st.a < value;
+    st.p = parity((ans & 0xFF), 8);
+    st.a = (uint8_t) ans;
+}
+
+static void ana_loop(Unpacked& st, uint8_t value)
+{
+    st.a &= value;
+    st.c = 0;
+    st.z = st.a == 0;
+    st.s = (st.a & 0x80) == 0x80;
+    st.p = parity(st.a, 8);
+}
+
+// The old CMP only set Z and C, this sets S and P too so both versions do the same work
+static void cmp_loop(Unpacked& st, uint8_t value)
+{
+    uint8_t ans = st.a - value;
+    st.z = ans == 0;
+    st.s = (ans & 0x80) == 0x80;
+    st.c = st.a < value;
+    st.p = parity(ans, 8);
+}
+
+static void add_table(Packed& st, uint8_t value)
+{
+    uint16_t ans = st.a + value;
+    st.flags.set(FLAGS_ALL, SZP[(uint8_t) ans] | ((st.a ^ value ^ ans) & FLAG_AC) | (ans >> 8));
+    st.a = (uint8_t) ans;
+}
+
+static void sub_table(Packed& st, uint8_t value)
+{
+    uint16_t ans = st.a - value;
+    st.flags.set(FLAGS_ALL, SZP[(uint8_t) ans] | (~(st.a ^ value ^ ans) & FLAG_AC) | ((ans >> 8) & FLAG_C));
+    st.a = (uint8_t) ans;
+}
+
+static void ana_table(Packed& st, uint8_t value)
+{
+    uint8_t ans = st.a & value;
+    st.flags.set(FLAGS_ALL, SZP[ans] | (((st.a | value) << 1) & FLAG_AC));
+    st.a = ans;
+}
+
+static void cmp_table(Packed& st, uint8_t value)
+{
+    uint8_t a = st.a;
+    sub_table(st, value);
+    st.a = a;
+}
+
+static uint64_t ticks()
+{
+    #if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+    #else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    #endif
+}
+
+// Returns the ticks per operation, and the checksum of the S, Z, P and C flags after every operation
+template <typename State, typename F>
+static double measure(F op, uint32_t& checksum)
+{
+    // Random operands so the results can't be predicted
+    static uint8_t operands[OPERANDS];
+    uint32_t seed = 12345;
+    for (int i = 0; i < OPERANDS; ++i)
+    {
+        seed = seed * 1664525 + 1013904223;
+        operands[i] = (uint8_t) (seed >> 24);
+    }
+
+    // CMP and ANA on their own would keep A fixed or drive it to zero, so every operation also adds the operand
+    State st = {};
+    checksum = 0;
+
+    uint64_t start = ticks();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        uint8_t value = operands[i & (OPERANDS - 1)];
+        op(st, value);
+        checksum += st.szpc();
+        st.a += value;
+    }
+    uint64_t end = ticks();
+
+    return (double) (end - start) / ITERATIONS;
+}
+
+template <typename F, typename G>
+static bool compare(const char* name, F loop_op, G table_op)
+{
+    uint32_t loop_checksum, table_checksum;
+    double loop = measure<Unpacked>(loop_op, loop_checksum);
+    double table = measure<Packed>(table_op, table_checksum);
+
+    bool same = loop_checksum == table_checksum;
+    printf("%-4s %10.2f %10.2f %10.2f %7.1fx  %s\n", name, loop, table, loop - table, loop / table,
+        same ? "same flags" : "FLAGS DIFFER");
+    return same;
+}
+
+int main()
+{
+    #if defined(__x86_64__) || defined(__i386__)
+        printf("Timing with rdtsc, ticks are reference cycles\n");
+    #else
+        printf("Timing with steady_clock, ticks are nanoseconds\n");
+    #endif
+
+    printf("%-4s %10s %10s %10s %8s\n", "op", "loop", "table", "saved", "speedup");
+    bool same = compare("ADD", add_loop, add_table);
+    same &= compare("SUB", sub_loop, sub_table);
+    same &= compare("ANA", ana_loop, ana_table);
+    same &= compare("CMP", cmp_loop, cmp_table);
+    return same ? 0 : 1;
+}
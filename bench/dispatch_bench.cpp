@@ -0,0 +1,131 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "../src/i8080.hpp"
+
+// Checks that every interpreter core behaves the same, then reports how fast each one is
+// Run with `make dispatch-bench && ./dispatch-bench <ROM> [cycles]`
+
+#define VERIFY_INSTRUCTIONS 1000000
+#define MEMORY_CHECK_INTERVAL 4096 // Instructions between full memory comparisons
+
+struct Core
+{
+    const char* name;
+    int (I8080::*run)(int budget);
+};
+
+static const Core cores[] = {
+    { "switch", &I8080::run_switch },
+    { "table", &I8080::run_table },
+    #ifdef __GNUC__
+        { "threaded", &I8080::run_threaded },
+    #endif
+};
+static const int core_count = sizeof(cores) / sizeof(cores[0]);
+
+#define HALF_FRAME ((CLOCK_SPEED / FPS) / 2)
+
+// Screen interrupt state for one CPU, the deadline is an absolute cycle count
+struct Interrupts
+{
+    uint64_t next = HALF_FRAME;
+    int vector = 0x0008;
+};
+
+// Fire the screen interrupts the same way the machine does so the interrupt handlers get run as well
+static void interrupts(I8080& cpu, Interrupts& irq)
+{
+    if (cpu.cycle_count() >= irq.next)
+    {
+        cpu.generate_interrupt(irq.vector);
+        irq.vector = irq.vector == 0x0008 ? 0x0010 : 0x0008;
+        irq.next += HALF_FRAME;
+    }
+}
+
+// Returns the average cycles per instruction, or 0 when the cores disagree
+static double verify(const char* rom)
+{
+    std::unique_ptr<I8080> cpus[core_count];
+    Interrupts irqs[core_count];
+    for (int i = 0; i < core_count; ++i)
+    {
+        cpus[i].reset(new I8080());
+        cpus[i]->load_rom(rom);
+    }
+
+    long cycles = 0;
+    for (long n = 0; n < VERIFY_INSTRUCTIONS; ++n)
+    {
+        for (int i = 0; i < core_count; ++i)
+        {
+            int used = (*cpus[i].*cores[i].run)(1); // One instruction at a time
+            if (i == 0) cycles += used;
+            interrupts(*cpus[i], irqs[i]);
+        }
+
+        for (int i = 1; i < core_count; ++i)
+        {
+            bool same = cpus[i]->state() == cpus[0]->state() && cpus[i]->cycle_count() == cpus[0]->cycle_count();
+            if (same && (n % MEMORY_CHECK_INTERVAL == 0 || n == VERIFY_INSTRUCTIONS - 1))
+                same = memcmp(cpus[i]->memory_at(0), cpus[0]->memory_at(0), 65536) == 0;
+
+            if (!same)
+            {
+                printf("%s core differs from %s after %ld instructions (pc %04x vs %04x)\n",
+                    cores[i].name, cores[0].name, n + 1, cpus[i]->state().pc, cpus[0]->state().pc);
+                return 0;
+            }
+        }
+    }
+
+    printf("All %d cores match for %d instructions\n", core_count, VERIFY_INSTRUCTIONS);
+    return (double) cycles / VERIFY_INSTRUCTIONS;
+}
+
+// Runs the core for the given number of cycles, either one instruction per call or a whole interrupt period per call
+static double measure(const char* rom, const Core& core, long cycles, bool batched)
+{
+    std::unique_ptr<I8080> cpu(new I8080());
+    cpu->load_rom(rom);
+    Interrupts irq;
+
+    auto start = std::chrono::steady_clock::now();
+    for (long ran = 0; ran < cycles;)
+    {
+        if (batched) ran += (*cpu.*core.run)((int) (irq.next - cpu->cycle_count()));
+        else ran += (*cpu.*core.run)(1);
+        interrupts(*cpu, irq);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return cycles / elapsed.count();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "Usage: dispatch-bench <ROM> [cycles]\n");
+        return 1;
+    }
+
+    long cycles = argc == 3 ? atol(argv[2]) : 1000000000;
+
+    double cycles_per_instruction = verify(argv[1]);
+    if (cycles_per_instruction == 0) return 2;
+
+    // Instruction counts are estimated from the average cycles per instruction seen while verifying
+    printf("%-8s %22s %22s\n", "core", "stepped (M instr/s)", "batched (M instr/s)");
+    for (int i = 0; i < core_count; ++i)
+    {
+        double stepped = measure(argv[1], cores[i], cycles, false) / cycles_per_instruction;
+        double batched = measure(argv[1], cores[i], cycles, true) / cycles_per_instruction;
+        printf("%-8s %22.2f %22.2f\n", cores[i].name, stepped / 1e6, batched / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "../src/invaders.hpp"
+
+// Runs a ROM headless and as fast as possible, then prints the results as one line of JSON
+// Run with `make invaders-bench && ./invaders-bench <ROM> [frames]`
+
+#define DEFAULT_FRAMES 6000 // 100 seconds of emulated time
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "Usage: invaders-bench <ROM> [frames]\n");
+        return 1;
+    }
+
+    long frames = argc == 3 ? atol(argv[2]) : DEFAULT_FRAMES;
+
+    std::unique_ptr<Invaders> invaders(new Invaders());
+    invaders->load_rom(argv[1]);
+
+    uint64_t cycles = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    while (invaders->frames < (uint64_t) frames) cycles += invaders->run_frame();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Interrupts the CPU took, the ones raised while it had them disabled don't count
+    uint64_t interrupts = invaders->cpu.interrupt_count();
+    uint64_t instructions = invaders->cpu.instruction_count();
+    // Cycles skipped over while halted cost nothing to run, so executed_mhz leaves them out and emulated_mhz doesn't
+    uint64_t halted = invaders->cpu.halted_cycle_count();
+
+    printf("{\"rom\": \"%s\", \"frames\": %ld, \"cycles\": %llu, \"halted_cycles\": %llu, \"instructions\": %llu, "
+        "\"interrupts\": %llu, \"seconds\": %.6f, \"emulated_mhz\": %.3f, \"executed_mhz\": %.3f, "
+        "\"ns_per_instruction\": %.3f, \"interrupts_per_second\": %.1f}\n",
+        argv[1], frames, (unsigned long long) cycles, (unsigned long long) halted, (unsigned long long) instructions,
+        (unsigned long long) interrupts, seconds, cycles / seconds / 1e6, (cycles - halted) / seconds / 1e6,
+        seconds * 1e9 / instructions, interrupts / seconds);
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "../src/lockstep.hpp"
+
+// Runs the same ROM, mapped read-only at 0x0000, on N separate I8080s and on an N lane Lockstep,
+// checks every lane ends up the same as its I8080, and compares the instructions per second of both
+// Each lane starts with B and C set from its lane number so the data differs and branches can split the lanes
+// Run with `make lockstep-bench && ./lockstep-bench <ROM> [lanes] [cycles]`
+
+#define DEFAULT_LANES 256
+#define DEFAULT_CYCLES 2000000
+
+static I8080::CoreState seeded(I8080::CoreState core, int lane)
+{
+    core.registers.b = lane;
+    core.registers.c = lane * 7;
+    return core;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 4)
+    {
+        fprintf(stderr, "Usage: lockstep-bench <ROM> [lanes] [cycles]\n");
+        return 1;
+    }
+
+    int lanes = argc >= 3 ? atoi(argv[2]) : DEFAULT_LANES;
+    int cycles = argc == 4 ? atoi(argv[3]) : DEFAULT_CYCLES;
+    if (lanes <= 0 || cycles <= 0)
+    {
+        fprintf(stderr, "Lanes and cycles have to be positive\n");
+        return 1;
+    }
+
+    #ifdef __AVX2__
+        printf("Built with AVX2\n");
+    #else
+        printf("Built without AVX2, SIMD steps use whatever vector width the target has\n");
+    #endif
+
+    Lockstep lockstep(lanes);
+    lockstep.load_rom(argv[1]);
+
+    std::vector<std::unique_ptr<I8080>> cpus;
+    for (int i = 0; i < lanes; ++i)
+    {
+        cpus.emplace_back(new I8080());
+        cpus[i]->map_rom(0x0000, lockstep.rom_bytes(), lockstep.rom_image());
+        cpus[i]->init();
+
+        I8080::CoreState core = seeded(lockstep.lane_state(i), i);
+        cpus[i]->restore(core);
+        lockstep.set_lane_state(i, core);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < lanes; ++i) cpus[i]->run_cycles(cycles);
+    double scalar_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    lockstep.run(cycles);
+    double lockstep_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t instructions = 0;
+    int differing = 0;
+    for (int i = 0; i < lanes; ++i)
+    {
+        I8080::CoreState lane = lockstep.lane_state(i);
+        bool same = lane.registers == cpus[i]->state() && lane.total_cycles == cpus[i]->cycle_count() &&
+            lane.instructions == cpus[i]->instruction_count() && lane.halted == cpus[i]->core_state().halted;
+        for (int page = 0; page < MEMORY_PAGES && same; ++page)
+        {
+            uint16_t address = page * MEMORY_PAGE_SIZE;
+            same = memcmp(lockstep.lane(i).memory_at(address), cpus[i]->memory_at(address), MEMORY_PAGE_SIZE) == 0;
+        }
+        if (!same && differing++ == 0)
+            printf("Lane %d differs from its I8080 (pc %04x vs %04x)\n", i, lane.registers.pc, cpus[i]->state().pc);
+        instructions += cpus[i]->instruction_count();
+    }
+
+    uint64_t vectored = lockstep.vector_instructions();
+    printf("%d lanes x %d cycles, %llu instructions, %.1f%% of them run as SIMD\n", lanes, cycles,
+        (unsigned long long) instructions, 100.0 * vectored / (vectored + lockstep.scalar_instructions()));
+    printf("%-10s %14s\n", "engine", "M instr/s");
+    printf("%-10s %14.2f\n", "scalar", instructions / scalar_seconds / 1e6);
+    printf("%-10s %14.2f\n", "lockstep", instructions / lockstep_seconds / 1e6);
+
+    if (differing != 0)
+    {
+        printf("%d lanes differ\n", differing);
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "../src/frame_hash.hpp"
+#include "../src/rewind.hpp"
+
+// Records a rewind snapshot every frame and reports the memory it takes, then seeks back and checks
+// the restored machine hashes the same as when it was recorded, and replays the same way
+// Then saves the machine, loads the blob into a second board and checks both play on the same, and that
+// truncated blobs and blobs made with another ROM are turned away
+// Run with `make rewind-bench && ./rewind-bench <ROM> [frames]`
+
+#define SEEK_BACK 600 // Ten seconds
+#define REPLAY_FRAMES 300
+#define STATE_LOOPS 1000 // Saves and loads timed
+#define STATE_TARGET 1e-3 // Seconds allowed for one save or load
+
+// Returns false if the blob didn't load back into a board that plays on exactly like the one it came from
+static bool check_save_state(Invaders& invaders, const char* rom)
+{
+    std::vector<uint8_t> blob;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < STATE_LOOPS; ++i) blob = invaders.save_state();
+    double save = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / STATE_LOOPS;
+
+    std::shared_ptr<const Invaders::RomImage> image = Invaders::read_rom(rom);
+    std::unique_ptr<Invaders> copy(new Invaders());
+    copy->use_rom(image);
+
+    bool loaded = true;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < STATE_LOOPS; ++i) loaded &= copy->load_state(blob);
+    double load = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / STATE_LOOPS;
+
+    if (!loaded || frame_hash(copy->cpu) != frame_hash(invaders.cpu))
+    {
+        printf("Loading a save state didn't restore the saved machine\n");
+        return false;
+    }
+
+    for (int i = 1; i <= REPLAY_FRAMES; ++i)
+    {
+        invaders.run_frame();
+        copy->run_frame();
+        if (frame_hash(copy->cpu) != frame_hash(invaders.cpu))
+        {
+            printf("Loaded state differs %d frames after loading\n", i);
+            return false;
+        }
+    }
+
+    // Neither of these may load, or touch the board
+    uint64_t before = frame_hash(copy->cpu);
+    std::vector<uint8_t> truncated(blob.begin(), blob.end() - 1);
+    if (copy->load_state(truncated) || frame_hash(copy->cpu) != before)
+    {
+        printf("A truncated save state was accepted\n");
+        return false;
+    }
+
+    std::shared_ptr<Invaders::RomImage> other(new Invaders::RomImage(*image));
+    other->bytes[ROM_END - 1] ^= 0xFF;
+    std::unique_ptr<Invaders> modified(new Invaders());
+    modified->use_rom(other);
+    if (modified->load_state(blob))
+    {
+        printf("A save state from another ROM was accepted\n");
+        return false;
+    }
+
+    printf("Save state of %zu bytes saved in %.2f us and loaded in %.2f us, replayed %d frames identically\n",
+        blob.size(), save * 1e6, load * 1e6, REPLAY_FRAMES);
+    if (save > STATE_TARGET || load > STATE_TARGET)
+    {
+        printf("Saving or loading took longer than %.0f us\n", STATE_TARGET * 1e6);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "Usage: rewind-bench <ROM> [frames]\n");
+        return 1;
+    }
+
+    long frames = argc == 3 ? atol(argv[2]) : REWIND_FRAMES;
+    if (frames <= SEEK_BACK + REPLAY_FRAMES)
+    {
+        fprintf(stderr, "Needs more than %d frames\n", SEEK_BACK + REPLAY_FRAMES);
+        return 1;
+    }
+
+    std::unique_ptr<Invaders> invaders(new Invaders());
+    invaders->load_rom(argv[1]);
+    std::unique_ptr<Rewind> rewind(new Rewind(frames));
+
+    std::vector<uint64_t> hashes; // Hash after each frame, in the order they were recorded
+    std::chrono::duration<double> recording(0);
+    for (long frame = 0; frame < frames; ++frame)
+    {
+        invaders->run_frame();
+        hashes.push_back(frame_hash(invaders->cpu));
+
+        auto start = std::chrono::steady_clock::now();
+        rewind->record(*invaders);
+        recording += std::chrono::steady_clock::now() - start;
+    }
+
+    printf("%d snapshots, %.1f KB of pages (%.2f KB per frame), %.2f us per snapshot\n", rewind->size(),
+        rewind->page_bytes() / 1024.0, rewind->page_bytes() / 1024.0 / rewind->size(), recording.count() * 1e6 / frames);
+
+    auto start = std::chrono::steady_clock::now();
+    bool found = rewind->seek(*invaders, SEEK_BACK);
+    std::chrono::duration<double> seeking = std::chrono::steady_clock::now() - start;
+
+    long frame = frames - 1 - SEEK_BACK;
+    if (!found || frame_hash(invaders->cpu) != hashes[frame])
+    {
+        printf("Seeking back %d frames didn't restore the recorded state\n", SEEK_BACK);
+        return 2;
+    }
+
+    // Running on from the restored state has to play out exactly as it did the first time
+    for (int i = 1; i <= REPLAY_FRAMES; ++i)
+    {
+        invaders->run_frame();
+        if (frame_hash(invaders->cpu) != hashes[frame + i])
+        {
+            printf("Replay differs %d frames after the seek\n", i);
+            return 2;
+        }
+    }
+
+    printf("Seeked back %d frames in %.2f us, replayed %d frames identically\n", SEEK_BACK, seeking.count() * 1e6, REPLAY_FRAMES);
+
+    if (!check_save_state(*invaders, argv[1])) return 2;
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "../src/invaders.hpp"
+
+// Times the VRAM to RGBA conversion on its own, after checking both converters draw the same image
+// Then runs the game rendering only dirty scanlines, to see how much of the screen changes per frame
+// Run with `make video-bench && ./video-bench <ROM> [conversions]`
+
+#define WARMUP_FRAMES 600 // Let the attract mode put something on screen first
+#define DIRTY_FRAMES 600
+
+// Returns true when both converters give the same image for this VRAM
+static bool verify(Video& fast, Video& scalar, const uint8_t* vram)
+{
+    fast.convert(vram);
+    scalar.convert_scalar(vram);
+    return memcmp(fast.pixels, scalar.pixels, sizeof(fast.pixels)) == 0;
+}
+
+// Returns conversions per second
+static double measure(Video& video, const uint8_t* vram, long conversions, bool scalar)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (long n = 0; n < conversions; ++n)
+    {
+        if (scalar) video.convert_scalar(vram);
+        else video.convert(vram);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return conversions / elapsed.count();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "Usage: video-bench <ROM> [conversions]\n");
+        return 1;
+    }
+
+    long conversions = argc == 3 ? atol(argv[2]) : 20000;
+
+    std::unique_ptr<Invaders> invaders(new Invaders());
+    invaders->load_rom(argv[1]);
+    while (invaders->frames < WARMUP_FRAMES) invaders->run_frame();
+    const uint8_t* vram = invaders->cpu.memory_at(VRAM_START);
+
+    // Random noise as well, so every bit position gets checked even if the ROM draws little
+    uint8_t noise[VRAM_SIZE];
+    srand(8080);
+    for (int i = 0; i < VRAM_SIZE; ++i) noise[i] = rand() & 0xFF;
+
+    std::unique_ptr<Video> fast(new Video()), scalar(new Video());
+    if (!verify(*fast, *scalar, vram) || !verify(*fast, *scalar, noise))
+    {
+        printf("Converters disagree\n");
+        return 2;
+    }
+    printf("Converters match\n");
+
+    double fast_fps = measure(*fast, vram, conversions, false);
+    double scalar_fps = measure(*scalar, vram, conversions, true);
+    printf("%-8s %14s\n", "kernel", "frames/s");
+    printf("%-8s %14.0f\n", "block", fast_fps);
+    printf("%-8s %14.0f\n", "scalar", scalar_fps);
+
+    // Render every frame the way the game loop would, only timing the conversion
+    invaders->render();
+    long converted = 0;
+    std::chrono::duration<double> elapsed(0);
+    for (int frame = 0; frame < DIRTY_FRAMES; ++frame)
+    {
+        invaders->run_frame();
+        auto start = std::chrono::steady_clock::now();
+        converted += invaders->render();
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    // The image built from dirty scanlines alone has to match a full conversion
+    fast->convert(vram);
+    if (memcmp(fast->pixels, invaders->video->pixels, sizeof(fast->pixels)) != 0)
+    {
+        printf("Dirty scanline tracking missed a write\n");
+        return 2;
+    }
+    printf("%-8s %14.0f   %.1f of %d scanlines per frame\n", "dirty", DIRTY_FRAMES / elapsed.count(),
+        (double) converted / DIRTY_FRAMES, VRAM_ROWS);
+    return 0;
+}
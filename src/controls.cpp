@@ -0,0 +1,23 @@
+#include "controls.hpp"
+
+void Controls::attach(IOBus& bus)
+{
+    bus.map_in(INPUT_PORT_0, read_port, this);
+    bus.map_in(INPUT_PORT_1, read_port, this);
+    bus.map_in(INPUT_PORT_2, read_port, this);
+}
+
+void Controls::set(uint8_t port, uint8_t mask, bool pressed)
+{
+    if (port >= INPUT_PORTS) return;
+
+    if (pressed) ports[port] |= mask;
+    else ports[port] &= ~mask;
+}
+
+uint8_t Controls::read_port(void* device, uint8_t port)
+{
+    port &= INPUT_PORT_MASK;
+    if (port >= INPUT_PORTS) return 0;
+    return ((Controls*) device)->ports[port];
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#include "io.hpp"
+
+#define INPUT_PORT_0 0 // IN: Unused by the game
+#define INPUT_PORT_1 1 // IN: Coin, start buttons and player 1
+#define INPUT_PORT_2 2 // IN: DIP switches and player 2
+#define INPUT_PORTS 3 // Ports from here on read as zero
+#define INPUT_PORT_MASK 0x07 // The board only decodes A0-A2, so IN passes on port numbers that alias these
+
+// Button bits on ports 1 and 2, a set bit means pressed
+#define BUTTON_COIN 0x01 // Port 1
+#define BUTTON_START_2 0x02 // Port 1
+#define BUTTON_START_1 0x04 // Port 1
+#define BUTTON_FIRE 0x10 // Port 1 for player 1, port 2 for player 2
+#define BUTTON_LEFT 0x20
+#define BUTTON_RIGHT 0x40
+
+// The cabinet buttons and DIP switches, read through IN
+class Controls
+{
+    public:
+        void attach(IOBus& bus);
+
+        // Press or release the buttons in mask on an input port, ports without buttons are ignored
+        void set(uint8_t port, uint8_t mask, bool pressed);
+
+    private:
+        uint8_t ports[INPUT_PORTS] = {
+            0x0E, // Bits 1-3 are tied high
+            0x08, // Bit 3 is tied high
+            0x00, // 3 ships, extra ship at 1500, coin info shown
+        };
+
+        static uint8_t read_port(void* device, uint8_t port);
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 lookup table for the reflected 0xEDB88320 polynomial, the one zip and MAME use
+struct CRC32Table
+{
+    uint32_t crc[256];
+
+    constexpr CRC32Table() : crc()
+    {
+        for (uint32_t x = 0; x < 256; ++x)
+        {
+            uint32_t c = x;
+            for (int i = 0; i < 8; ++i) c = c & 1 ? (c >> 1) ^ 0xEDB88320 : c >> 1;
+            crc[x] = c;
+        }
+    }
+};
+
+static constexpr CRC32Table CRC32_TABLE;
+
+// Pass the CRC of the data so far to carry on from it
+inline uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = CRC32_TABLE.crc[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
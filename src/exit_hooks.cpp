@@ -0,0 +1,70 @@
+#include "exit_hooks.hpp"
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+
+struct ExitHook
+{
+    void (*callback)(void*);
+    void* data;
+};
+
+static ExitHook hooks[EXIT_HOOKS] = {};
+static bool installed = false;
+static volatile sig_atomic_t stop_signal = 0;
+
+static void run_exit_hooks()
+{
+    for (int i = 0; i < EXIT_HOOKS; ++i)
+    {
+        if (hooks[i].callback != NULL) finish_exit_hook(hooks[i].callback, hooks[i].data);
+    }
+}
+
+static void record_signal(int sig)
+{
+    // Only async-signal-safe calls here, the default action comes back for a second Ctrl+C
+    stop_signal = sig;
+    std::signal(sig, SIG_DFL);
+}
+
+void add_exit_hook(void (*callback)(void*), void* data)
+{
+    if (!installed)
+    {
+        std::atexit(run_exit_hooks);
+        std::signal(SIGINT, record_signal);
+        std::signal(SIGTERM, record_signal);
+        installed = true;
+    }
+
+    for (int i = 0; i < EXIT_HOOKS; ++i)
+    {
+        if (hooks[i].callback == NULL)
+        {
+            hooks[i] = {callback, data};
+            return;
+        }
+    }
+
+    std::cerr << "Too many exit hooks, at most " << EXIT_HOOKS << " can be added" << std::endl;
+    exit(1);
+}
+
+void finish_exit_hook(void (*callback)(void*), void* data)
+{
+    for (int i = 0; i < EXIT_HOOKS; ++i)
+    {
+        if (hooks[i].callback == callback && hooks[i].data == data)
+        {
+            hooks[i] = {};
+            callback(data);
+        }
+    }
+}
+
+int exit_signal()
+{
+    return stop_signal;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#define EXIT_HOOKS 4 // Most callbacks that can be waiting for the program to exit at once
+
+// Call callback(data) once, either when the program exits or from finish_exit_hook, whichever comes first
+// Once a hook is added SIGINT and SIGTERM only record the signal, see exit_signal
+void add_exit_hook(void (*callback)(void*), void* data);
+
+// Run a callback added with the same data now rather than at exit, for objects destroyed before the program exits
+void finish_exit_hook(void (*callback)(void*), void* data);
+
+// The SIGINT or SIGTERM that asked the program to stop, or 0
+// Hooks write files and use stdio, which isn't safe inside a signal handler, so the handler only sets this and the
+// main loop returns normally when it sees it. A second signal stops the program straight away
+int exit_signal();
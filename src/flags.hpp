@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+// Bit positions of the flags in the 8080 PSW
+#define FLAG_C 0x01 // Carry flag
+#define FLAG_P 0x04 // Parity flag
+#define FLAG_AC 0x10 // Auxiliary carry
+#define FLAG_Z 0x40 // Zero flag
+#define FLAG_S 0x80 // Sign flag
+#define FLAGS_ALL (FLAG_S | FLAG_Z | FLAG_AC | FLAG_P | FLAG_C)
+
+// Sign, zero and parity flags of every 8-bit result, in the PSW layout
+struct SZPTable
+{
+    uint8_t flags[256];
+
+    constexpr SZPTable() : flags()
+    {
+        for (int x = 0; x < 256; ++x)
+        {
+            int bits = 0;
+            for (int i = 0; i < 8; ++i) bits += (x >> i) & 1;
+
+            flags[x] = (x & FLAG_S) | (x == 0 ? FLAG_Z : 0) | ((bits & 1) == 0 ? FLAG_P : 0);
+        }
+    }
+
+    constexpr uint8_t operator[](uint8_t x) const { return flags[x]; }
+};
+
+// Computed at compile time so the ALU only does a table load per result
+static constexpr SZPTable SZP;
+
+// Flags, packed in the same layout as the 8080 PSW
+struct Flags
+{
+    uint8_t psw;
+
+    bool s() const { return psw & FLAG_S; } // Sign flag
+    bool z() const { return psw & FLAG_Z; } // Zero flag
+    bool p() const { return psw & FLAG_P; } // Parity flag
+    bool c() const { return psw & FLAG_C; } // Carry flag
+    bool ac() const { return psw & FLAG_AC; } // Auxiliary carry
+
+    // Replace the flags in mask with the bits from value
+    void set(uint8_t mask, uint8_t value) { psw = (psw & ~mask) | value; }
+    void set_c(bool carry) { set(FLAG_C, carry); }
+};
@@ -0,0 +1,36 @@
+#include "frame_hash.hpp"
+
+#include <cstring>
+
+// Folds 8 bytes into the hash, one multiply per word keeps a whole frame to a few microseconds
+static inline uint64_t mix(uint64_t hash, uint64_t value)
+{
+    hash ^= value * 0x9E3779B97F4A7C15ULL;
+    hash = (hash << 27) | (hash >> 37);
+    return hash * 0xC2B2AE3D27D4EB4FULL;
+}
+
+uint64_t frame_hash(const I8080& cpu)
+{
+    uint64_t hash = 0x8080;
+
+    const uint8_t* vram = cpu.memory_at(VRAM_START);
+    for (int i = 0; i < VRAM_SIZE; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, vram + i, 8);
+        hash = mix(hash, word);
+    }
+
+    I8080::CPUState state = cpu.state();
+    hash = mix(hash, (uint64_t) state.a << 56 | (uint64_t) state.b << 48 | (uint64_t) state.c << 40 |
+        (uint64_t) state.d << 32 | (uint64_t) state.e << 24 | (uint64_t) state.h << 16 | (uint64_t) state.l << 8 | state.psw);
+    hash = mix(hash, (uint64_t) state.sp << 16 | (uint64_t) state.pc);
+    hash = mix(hash, cpu.cycle_count());
+
+    // Final avalanche so every input bit can reach every output bit
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return hash;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+#include "i8080.hpp"
+
+// 64-bit hash of video RAM, the registers and the cycle count
+// Two runs that hash the same at every frame drew the same picture with the same CPU state
+uint64_t frame_hash(const I8080& cpu);
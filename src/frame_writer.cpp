@@ -0,0 +1,38 @@
+#include "frame_writer.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+FrameWriter::FrameWriter(const char* pattern) : pattern(pattern)
+{
+    memcpy(buffer, PPM_HEADER, sizeof(PPM_HEADER) - 1);
+}
+
+bool FrameWriter::write(const Video& video, uint64_t frame)
+{
+    // Pixels are RGBA in memory order, PPM wants RGB
+    uint8_t* out = buffer + sizeof(PPM_HEADER) - 1;
+    const uint8_t* in = (const uint8_t*) video.pixels;
+    for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; ++i, in += 4, out += 3)
+    {
+        out[0] = in[0];
+        out[1] = in[1];
+        out[2] = in[2];
+    }
+
+    char filename[64];
+    snprintf(filename, sizeof(filename), pattern, (unsigned long long) frame);
+
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL)
+    {
+        std::cerr << "Couldn't open frame file: " << filename << std::endl;
+        return false;
+    }
+
+    bool written = fwrite(buffer, 1, PPM_SIZE, file) == PPM_SIZE;
+    if (fclose(file) != 0) written = false;
+    if (!written) std::cerr << "Couldn't write frame file: " << filename << std::endl;
+    return written;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include "video.hpp"
+
+#define FRAME_FILE "frame-%06llu.ppm" // printf pattern given the frame number
+// Stringize after expanding, so the header is built from the screen size
+#define PPM_STRING(x) #x
+#define PPM_NUMBER(x) PPM_STRING(x)
+#define PPM_HEADER "P6\n" PPM_NUMBER(SCREEN_WIDTH) " " PPM_NUMBER(SCREEN_HEIGHT) "\n255\n"
+#define PPM_SIZE (sizeof(PPM_HEADER) - 1 + SCREEN_WIDTH * SCREEN_HEIGHT * 3)
+
+// Saves frames as binary PPM images
+// Each image is built in one buffer first, so saving it takes a single write
+class FrameWriter
+{
+    public:
+        FrameWriter(const char* pattern = FRAME_FILE);
+
+        // Returns false if the file couldn't be written
+        bool write(const Video& video, uint64_t frame);
+
+    private:
+        const char* pattern;
+        uint8_t buffer[PPM_SIZE];
+};
@@ -1,30 +1,64 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
+#include <memory>
+#include <vector>
 
-// Uncomment this if using the cpudiag rom
-// #define CPUDIAG
+#include "flags.hpp"
+#include "io.hpp"
+
+// Uncomment this (or build with `make trace`) to record every instruction executed
+// Release builds leave it off so no tracing code ends up in run_opcode
+// #define TRACE
+
+#ifdef TRACE
+    #include "trace.hpp"
+#endif
+
+// Uncomment this (or build with `make profile`) to count and time every opcode, reported at exit
+// #define PROFILE
+
+#ifdef PROFILE
+    #include "profiler.hpp"
+#endif
+
+// Interpreter core used by run_opcode, build with `make DISPATCH=<core>` to pick another one
+// `make dispatch-bench` checks the cores against each other and times them
+#define DISPATCH_SWITCH 0 // One switch statement over every opcode
+#define DISPATCH_TABLE 1 // Table of per-opcode handler functions
+#define DISPATCH_THREADED 2 // Computed goto, needs GCC or Clang
+
+#ifndef DISPATCH
+    #define DISPATCH DISPATCH_SWITCH
+#endif
+
+#define STATE_VERSION 4 // Bump whenever the save state layout changes
 
 #define CLOCK_SPEED 2000000
 #define FPS 1/60
 
+// Video RAM of the Space Invaders board, one bit per pixel
+#define VRAM_START 0x2400
+#define VRAM_SIZE 0x1C00
+#define VRAM_ROW_BYTES 32 // Bytes in one scanline of the unrotated raster
+#define VRAM_ROWS (VRAM_SIZE / VRAM_ROW_BYTES)
+
+// Memory is mapped and tracked in pages, one bit per page fits a 64-bit mask
+#define MEMORY_PAGE_SIZE 1024
+#define MEMORY_PAGES (65536 / MEMORY_PAGE_SIZE)
+
 class I8080
 {
     public:
-        int cycles;
-        int total_cycles = 0;
-        int last_interrupt;
-
-        void load_rom(const char* filename);
-        void run_opcode();
-        void generate_interrupt(uint interrupt);
+        IOBus* io = &unmapped; // Devices used by IN and OUT
 
-    private:
-        uint8_t memory[65536]; // 64 K of memory
+        // With flat_memory the CPU owns 64K of RAM, otherwise every page starts unmapped until a machine maps its own
+        I8080(bool flat_memory = true);
 
-        // Registers
-        struct regs
+        // Registers visible to the program
+        struct CPUState
         {
             uint8_t a;
             uint8_t b;
@@ -33,22 +67,180 @@ class I8080
             uint8_t e;
             uint8_t h;
             uint8_t l;
-        } regs;
+            uint8_t psw;
+            uint16_t sp;
+            uint16_t pc;
+
+            bool operator==(const CPUState& other) const
+            {
+                return a == other.a && b == other.b && c == other.c && d == other.d && e == other.e &&
+                    h == other.h && l == other.l && psw == other.psw && sp == other.sp && pc == other.pc;
+            }
+        };
 
-        // Flags
-        struct flags
+        // Everything about the CPU apart from memory
+        struct CoreState
         {
-            uint8_t s; // Sign flag
-            uint8_t z; // Zero flag
-            uint8_t p; // Parity flag
-            uint8_t c; // Carry flag
-            uint8_t ac; //Auxiliary carry
-        } flags;
+            CPUState registers;
+            bool inte;
+            bool ei_pending;
+            bool halted;
+            uint64_t total_cycles;
+            uint64_t instructions;
+        };
+
+        // Reset to the power on state, with registers, flags and memory cleared
+        void init();
+        // Reset, load a ROM image at origin and start running from there, CP/M programs use 0x100
+        void load_rom(const char* filename, uint16_t origin = 0);
+        // Read a file straight into memory at address, returns its size
+        // The file has to fit in the RAM mapped as one block from address, as all of memory is with flat memory
+        size_t load_file(const char* filename, uint16_t address);
+        // Read a whole file into buffer, exits if it can't be read or is larger than capacity
+        static size_t read_file(const char* filename, uint8_t* buffer, size_t capacity);
+        void load(uint16_t address, const uint8_t* data, size_t size); // Copy into memory, ROM is left alone
+
+        // Point a range of whole pages at memory owned by the machine, mapping the same RAM twice makes a mirror
+        // Writes to ROM are ignored, so any number of CPUs can share one copy of it
+        void map_ram(uint16_t address, size_t size, uint8_t* memory);
+        void map_rom(uint16_t address, size_t size, const uint8_t* memory);
+        void run_opcode();
+        // Run instructions until at least budget cycles have passed, returns the cycles actually run
+        int run_cycles(int budget);
+        void generate_interrupt(uint interrupt);
+
+        // run_cycles with a specific interpreter core
+        int run_switch(int budget);
+        int run_table(int budget);
+        #ifdef __GNUC__
+            int run_threaded(int budget);
+        #endif
+
+        // Counters since power on, 64 bits wide so they never wrap
+        uint64_t cycle_count() const { return total_cycles; }
+        uint64_t instruction_count() const { return instructions; }
+        // Not saved in states, these only count for statistics
+        uint64_t interrupt_count() const { return interrupts; } // Interrupts accepted, not ones ignored while disabled
+        uint64_t halted_cycle_count() const { return halted_cycles; } // Cycles skipped over while halted, part of cycle_count
+
+        CPUState state() const;
+
+        uint8_t read(uint16_t address) const { return reads[address / MEMORY_PAGE_SIZE][address % MEMORY_PAGE_SIZE]; }
+        // Memory as seen from address, only contiguous past the end of the page where the mapping is
+        const uint8_t* memory_at(uint16_t address) const { return &reads[address / MEMORY_PAGE_SIZE][address % MEMORY_PAGE_SIZE]; }
+
+        CoreState core_state() const;
+        void restore(const CoreState& core);
+
+        // Pages holding RAM of their own, leaving out ROM, mirrors and unmapped pages
+        uint64_t ram_pages() const { return ram; }
+        // RAM pages written since the last clear_written_pages, bit n is page n
+        uint64_t written_pages() const { return written & ram; }
+        void clear_written_pages() { written = 0; }
+
+        // Registers, interrupt state, counters and RAM as one versioned blob, ROM is only stored as a hash
+        std::vector<uint8_t> save_state() const;
+        // Returns false and leaves the CPU alone if the blob is from another version or other ROM contents
+        bool load_state(const std::vector<uint8_t>& blob);
+
+        // Scanlines of video RAM written since the last clear_dirty, bit n of byte b is scanline b * 8 + n
+        const uint8_t* dirty_rows() const { return dirty; }
+        void clear_dirty();
+
+        #ifdef TRACE
+            void dump_trace(const char* filename = TRACE_FILE) { trace.dump(filename); }
+        #endif
+
+    private:
+        static IOBus unmapped; // Bus with nothing attached, used until a machine sets io
+
+        // Where each page is read from and written to, writes to ROM and unmapped pages land in sink
+        const uint8_t* reads[MEMORY_PAGES];
+        uint8_t* writes[MEMORY_PAGES];
+        uint8_t home[MEMORY_PAGES]; // The page a mirror mirrors, or the page itself
+        uint64_t ram = 0; // Pages in ram_pages
+        uint8_t sink[MEMORY_PAGE_SIZE];
+        std::unique_ptr<uint8_t[]> flat; // 64K of RAM when built with flat memory
+
+        uint8_t dirty[VRAM_ROWS / 8];
+        uint64_t written; // Pages written since the last clear_written_pages
+
+        // Registers, each pair can also be used as a single 16-bit value
+        // The byte order inside a pair follows the host so the 16-bit view always has the high register on top
+        #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            #define REGISTER_PAIR(hi, lo) union { uint16_t hi##lo; struct { uint8_t hi; uint8_t lo; }; }
+        #else
+            #define REGISTER_PAIR(hi, lo) union { uint16_t hi##lo; struct { uint8_t lo; uint8_t hi; }; }
+        #endif
+        struct regs
+        {
+            uint8_t a;
+            REGISTER_PAIR(b, c);
+            REGISTER_PAIR(d, e);
+            REGISTER_PAIR(h, l);
+        } regs;
+        #undef REGISTER_PAIR
+
+        Flags flags;
 
         uint16_t sp; // Stack pointer
         uint16_t pc; // Program counter
         uint8_t opcode;
+        bool inte; // Interrupts enabled
+        bool ei_pending; // EI ran, interrupts are enabled once the instruction after it retires
+        bool halted; // Waiting for an interrupt after HLT
+        int cycles; // Cycles taken by the current instruction
+        uint64_t total_cycles; // Cycles run since power on
+        uint64_t instructions; // Instructions run since power on
+        uint64_t interrupts;
+        uint64_t halted_cycles;
+        uint64_t stop_at; // total_cycles at which the current run ends
 
-        void init();
-        bool parity(int x, int size);
+        #ifdef TRACE
+            TraceBuffer trace; // Most recent instructions, dumped at exit
+        #endif
+
+        #ifdef PROFILE
+            Profiler profiler;
+            uint64_t profile_start; // Host ticks when the current instruction was fetched
+        #endif
+
+        void fetch(); // Read the next opcode and move pc past it
+        void retire(); // Count the instruction that just ran, and finish an EI before it
+        void unimplemented();
+
+        uint32_t rom_hash() const; // CRC32 of the ROM pages
+
+        // Every store goes through here so writes mark their page, and writes to video RAM their scanline, dirty
+        // A write through a mirror counts as a write to the page it mirrors
+        void write(uint16_t address, uint8_t value)
+        {
+            int page = address / MEMORY_PAGE_SIZE;
+            writes[page][address % MEMORY_PAGE_SIZE] = value;
+            written |= 1ULL << home[page];
+
+            uint16_t offset = home[page] * MEMORY_PAGE_SIZE + address % MEMORY_PAGE_SIZE - VRAM_START;
+            if (offset < VRAM_SIZE)
+            {
+                int row = offset / VRAM_ROW_BYTES;
+                dirty[row / 8] |= 1 << (row % 8);
+            }
+        }
+
+        // Per-opcode handlers used by the table core
+        typedef void (I8080::*handler)();
+        static const handler handlers[256];
+        template <uint8_t OPCODE> void op();
+
+        // ALU helpers, these set the flags from the SZP table
+        void add(uint8_t value, uint8_t carry); // ADD, ADC, ADI and ACI
+        void sub(uint8_t value, uint8_t borrow); // SUB, SBB, SUI and SBI
+        void ana(uint8_t value); // ANA and ANI
+        void xra(uint8_t value); // XRA and XRI
+        void ora(uint8_t value); // ORA and ORI
+        void cmp(uint8_t value); // CMP and CPI
+        void daa(); // Decimal adjust A
+        void dad(uint16_t value); // Add a register pair to HL
+        uint8_t inr(uint8_t value);
+        uint8_t dcr(uint8_t value);
 };
@@ -0,0 +1,70 @@
+#include "input_script.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+struct Button
+{
+    const char* name;
+    uint8_t port;
+    uint8_t mask;
+};
+
+static const Button buttons[] = {
+    { "coin", INPUT_PORT_1, BUTTON_COIN },
+    { "start1", INPUT_PORT_1, BUTTON_START_1 },
+    { "start2", INPUT_PORT_1, BUTTON_START_2 },
+    { "fire1", INPUT_PORT_1, BUTTON_FIRE },
+    { "left1", INPUT_PORT_1, BUTTON_LEFT },
+    { "right1", INPUT_PORT_1, BUTTON_RIGHT },
+    { "fire2", INPUT_PORT_2, BUTTON_FIRE },
+    { "left2", INPUT_PORT_2, BUTTON_LEFT },
+    { "right2", INPUT_PORT_2, BUTTON_RIGHT },
+};
+
+bool InputScript::load(const char* filename)
+{
+    FILE* file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        std::cerr << "Couldn't open input script: " << filename << std::endl;
+        return false;
+    }
+
+    char line[256];
+    for (int number = 1; fgets(line, sizeof(line), file) != NULL; ++number)
+    {
+        unsigned long long frame;
+        char name[32], state[8];
+        int fields = sscanf(line, "%llu %31s %7s", &frame, name, state);
+        if (line[0] == '#' || fields == EOF) continue;
+
+        const Button* button = NULL;
+        for (const Button& b : buttons)
+            if (fields >= 2 && strcmp(name, b.name) == 0) button = &b;
+
+        bool down = fields == 3 && strcmp(state, "down") == 0;
+        if (button == NULL || (!down && (fields != 3 || strcmp(state, "up") != 0)))
+        {
+            std::cerr << filename << ":" << number << ": Expected `<frame> <button> down|up`" << std::endl;
+            fclose(file);
+            return false;
+        }
+
+        events.push_back({ frame, button->port, button->mask, down });
+    }
+    fclose(file);
+
+    // Events on the same frame keep the order they were written in
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.frame < b.frame; });
+    next = 0;
+    return true;
+}
+
+void InputScript::apply(uint64_t frame, Controls& controls)
+{
+    for (; next < events.size() && events[next].frame <= frame; ++next)
+        controls.set(events[next].port, events[next].mask, events[next].pressed);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "controls.hpp"
+
+// Button presses at fixed frames, so a run with inputs plays out the same way every time
+// One event per line as `<frame> <button> down|up`, lines starting with # are comments
+// Buttons are coin, start1, start2, fire1, left1, right1, fire2, left2 and right2
+class InputScript
+{
+    public:
+        // Returns false and reports the line if the script can't be read
+        bool load(const char* filename);
+
+        // Apply every event due by the start of frame
+        void apply(uint64_t frame, Controls& controls);
+
+    private:
+        struct Event
+        {
+            uint64_t frame;
+            uint8_t port;
+            uint8_t mask;
+            bool pressed;
+        };
+
+        std::vector<Event> events; // Sorted by frame
+        size_t next = 0;
+};
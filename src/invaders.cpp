@@ -0,0 +1,187 @@
+#include "invaders.hpp"
+
+#include <iomanip>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+
+#include "crc32.hpp"
+
+// The program ROMs on the board, as found in the usual split set
+static const struct RomFile
+{
+    const char* name;
+    uint16_t address;
+    uint16_t size;
+    uint32_t crc;
+} ROM_SET[] = {
+    { "invaders.h", 0x0000, 0x0800, 0x734F5AD8 },
+    { "invaders.g", 0x0800, 0x0800, 0x6BFACA4A },
+    { "invaders.f", 0x1000, 0x0800, 0x0CCEAD96 },
+    { "invaders.e", 0x1800, 0x0800, 0x14E538B0 },
+};
+
+Invaders::Invaders() : cpu(false)
+{
+    // The address decoding ignores A15 and the RAM also answers at 0x6000, leaving 0x4000 empty
+    for (uint16_t base : { 0x0000, 0x8000 })
+    {
+        cpu.map_ram(base + ROM_END, RAM_SIZE, ram);
+        cpu.map_ram(base + 0x6000, RAM_SIZE, ram);
+    }
+
+    shift_register.attach(bus);
+    controls.attach(bus);
+    bus.mirror(PORT_MASK);
+    cpu.io = &bus;
+
+    restore(Board());
+}
+
+std::shared_ptr<const Invaders::RomImage> Invaders::read_rom(const char* path)
+{
+    std::shared_ptr<RomImage> image(new RomImage());
+    memset(image->bytes, 0, sizeof(image->bytes));
+
+    struct stat info;
+    if (stat(path, &info) == 0 && S_ISDIR(info.st_mode)) read_rom_set(path, *image);
+    else
+    {
+        I8080::read_file(path, image->bytes, sizeof(image->bytes));
+        std::clog << "Loaded ROM successfully!" << std::endl;
+    }
+
+    return image;
+}
+
+void Invaders::use_rom(std::shared_ptr<const RomImage> image)
+{
+    rom = image;
+    cpu.map_rom(0x0000, ROM_END, rom->bytes);
+    cpu.map_rom(0x8000, ROM_END, rom->bytes);
+    cpu.init();
+
+    // Power on the rest of the board too, which also points the screen interrupts back at the first frame
+    restore(Board());
+}
+
+void Invaders::read_rom_set(const char* directory, RomImage& image)
+{
+    for (const RomFile& rom : ROM_SET)
+    {
+        std::string filename = std::string(directory) + "/" + rom.name;
+        size_t size = I8080::read_file(filename.c_str(), image.bytes + rom.address, ROM_END - rom.address);
+        if (size != rom.size)
+        {
+            std::cerr << filename << " is " << size << " bytes, expected " << rom.size << std::endl;
+            exit(4);
+        }
+
+        // Modified sets still run, so a bad CRC is only a warning
+        uint32_t crc = crc32(image.bytes + rom.address, size);
+        if (crc != rom.crc)
+            std::cerr << "Warning: " << filename << " has CRC32 " << std::hex << std::setfill('0') << std::setw(8) << crc
+                << ", expected " << std::setw(8) << rom.crc << std::dec << std::endl;
+    }
+
+    std::clog << "Loaded ROM set successfully!" << std::endl;
+}
+
+Invaders::Board Invaders::board_state() const
+{
+    Board board = Board(); // Value initialised, so padding is zero in saved states too
+    board.frames = frames;
+    board.shift_register = shift_register;
+    board.controls = controls;
+    return board;
+}
+
+// First deadline after now for an event that fires at first and then once every frame
+static uint64_t next_in_frame(uint64_t now, uint64_t first)
+{
+    if (now < first) return first;
+    return first + ((now - first) / FRAME_CYCLES + 1) * FRAME_CYCLES;
+}
+
+void Invaders::restore(const Board& board)
+{
+    frames = board.frames;
+    shift_register = board.shift_register;
+    controls = board.controls;
+
+    // The screen interrupts land at the same point of every frame, so the cycle count is all the scheduler needs
+    uint64_t now = cpu.cycle_count();
+    scheduler.reset(now);
+    scheduler.schedule(next_in_frame(now, FRAME_CYCLES / 2), mid_screen, this);
+    scheduler.schedule(next_in_frame(now, FRAME_CYCLES), vblank, this);
+}
+
+std::vector<uint8_t> Invaders::save_state() const
+{
+    Board board = board_state();
+    std::vector<uint8_t> blob = cpu.save_state();
+    const uint8_t* bytes = (const uint8_t*) &board;
+    blob.insert(blob.end(), bytes, bytes + sizeof(board));
+    return blob;
+}
+
+bool Invaders::load_state(const std::vector<uint8_t>& blob)
+{
+    Board board;
+    if (blob.size() < sizeof(board)) return false;
+
+    std::vector<uint8_t> cpu_blob(blob.begin(), blob.end() - sizeof(board));
+    if (!cpu.load_state(cpu_blob)) return false;
+
+    memcpy(&board, blob.data() + cpu_blob.size(), sizeof(board));
+    restore(board);
+    return true;
+}
+
+int Invaders::step()
+{
+    // The scheduler follows the CPU's cycle count, so deadlines stay exact however far a run overshoots
+    uint64_t start = cpu.cycle_count();
+    cpu.run_cycles((int) (scheduler.next() - start));
+    scheduler.advance_to(cpu.cycle_count());
+    return (int) (cpu.cycle_count() - start);
+}
+
+int Invaders::render()
+{
+    if (!video)
+    {
+        video.reset(new Video());
+        video->convert(cpu.memory_at(VRAM_START));
+        cpu.clear_dirty();
+        return VRAM_ROWS;
+    }
+
+    int converted = video->update(cpu.memory_at(VRAM_START), cpu.dirty_rows());
+    cpu.clear_dirty();
+    return converted;
+}
+
+int Invaders::run_frame()
+{
+    uint64_t frame = frames;
+    int cycles = 0;
+    while (frames == frame) cycles += step();
+    return cycles;
+}
+
+void Invaders::mid_screen(void* context, uint64_t when)
+{
+    Invaders* invaders = (Invaders*) context;
+    invaders->cpu.generate_interrupt(MID_SCREEN_INTERRUPT);
+    invaders->scheduler.schedule(when + FRAME_CYCLES, mid_screen, context);
+}
+
+void Invaders::vblank(void* context, uint64_t when)
+{
+    Invaders* invaders = (Invaders*) context;
+    invaders->cpu.generate_interrupt(VBLANK_INTERRUPT);
+    invaders->frames++;
+    invaders->scheduler.schedule(when + FRAME_CYCLES, vblank, context);
+}
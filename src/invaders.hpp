@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "controls.hpp"
+#include "i8080.hpp"
+#include "io.hpp"
+#include "scheduler.hpp"
+#include "shift_register.hpp"
+#include "video.hpp"
+
+#define ROM_END 0x2000 // 8K of program ROM, RAM starts here
+#define RAM_SIZE 0x2000 // 1K of work RAM followed by 7K of video RAM
+#define FRAME_CYCLES (CLOCK_SPEED / FPS) // Cycles in one video frame
+#define MID_SCREEN_INTERRUPT 0x0008 // RST 1, the beam is halfway down the screen
+#define VBLANK_INTERRUPT 0x0010 // RST 2, the beam has reached the bottom of the screen
+#define PORT_MASK 0x07 // The board only decodes A0-A2 of the port number, so every port answers at 32 numbers
+
+// The Space Invaders arcade board
+class Invaders
+{
+    public:
+        // The program ROM, which never changes so any number of boards can share one copy
+        struct RomImage
+        {
+            uint8_t bytes[ROM_END];
+        };
+
+        I8080 cpu;
+        IOBus bus;
+        ShiftRegister shift_register;
+        Controls controls;
+        Scheduler scheduler;
+        std::unique_ptr<Video> video; // Created by the first render, so headless boards never pay for the framebuffer
+        uint64_t frames = 0; // Frames finished since power on
+
+        Invaders();
+
+        // Read either a single ROM image, or a directory holding the split set invaders.h, .g, .f and .e
+        static std::shared_ptr<const RomImage> read_rom(const char* path);
+        // Map the ROM into memory and reset the CPU and the board, the board keeps its own reference to it
+        void use_rom(std::shared_ptr<const RomImage> image);
+        void load_rom(const char* path) { use_rom(read_rom(path)); }
+
+        // The board's own state, saved alongside the CPU
+        struct Board
+        {
+            uint64_t frames;
+            ShiftRegister shift_register;
+            Controls controls;
+        };
+
+        Board board_state() const;
+        // Restore the board after the CPU, this also works out the next screen interrupts from the cycle count
+        void restore(const Board& board);
+
+        // The CPU state plus the board's own state as one blob
+        std::vector<uint8_t> save_state() const;
+        bool load_state(const std::vector<uint8_t>& blob);
+
+        // Run the CPU up to the next scheduled event and fire it, returns the cycles run
+        int step();
+        // Run until the end of the current frame, returns the cycles run
+        int run_frame();
+        // Draw the scanlines of video RAM written since the last render into video->pixels
+        // Returns how many of the VRAM_ROWS scanlines were converted, the first render converts them all
+        int render();
+
+    private:
+        std::shared_ptr<const RomImage> rom;
+        uint8_t ram[RAM_SIZE];
+
+        static void read_rom_set(const char* directory, RomImage& image);
+
+        static void mid_screen(void* context, uint64_t when);
+        static void vblank(void* context, uint64_t when);
+};
@@ -0,0 +1,41 @@
+#include "io.hpp"
+
+// Unmapped ports read as zero and ignore writes
+static uint8_t unmapped_in(void*, uint8_t)
+{
+    return 0;
+}
+
+static void unmapped_out(void*, uint8_t, uint8_t)
+{
+}
+
+IOBus::IOBus()
+{
+    for (int i = 0; i < 256; ++i)
+    {
+        map_in(i, unmapped_in, nullptr);
+        map_out(i, unmapped_out, nullptr);
+    }
+}
+
+void IOBus::map_in(uint8_t port, reader read, void* device)
+{
+    inputs[port].read = read;
+    inputs[port].device = device;
+}
+
+void IOBus::map_out(uint8_t port, writer write, void* device)
+{
+    outputs[port].write = write;
+    outputs[port].device = device;
+}
+
+void IOBus::mirror(uint8_t mask)
+{
+    for (int port = 0; port < 256; ++port)
+    {
+        inputs[port] = inputs[port & mask];
+        outputs[port] = outputs[port & mask];
+    }
+}
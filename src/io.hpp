@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+// The 256 input and 256 output ports used by IN and OUT
+// Devices register a handler per port, so each access is one indirect call
+class IOBus
+{
+    public:
+        typedef uint8_t (*reader)(void* device, uint8_t port);
+        typedef void (*writer)(void* device, uint8_t port, uint8_t value);
+
+        IOBus();
+
+        void map_in(uint8_t port, reader read, void* device);
+        void map_out(uint8_t port, writer write, void* device);
+
+        // For boards that only decode the port bits in mask, copy the handlers of the ports within mask onto every
+        // other port number that decodes to them
+        void mirror(uint8_t mask);
+
+        uint8_t in(uint8_t port) { return inputs[port].read(inputs[port].device, port); }
+        void out(uint8_t port, uint8_t value) { outputs[port].write(outputs[port].device, port, value); }
+
+    private:
+        struct input
+        {
+            reader read;
+            void* device;
+        } inputs[256];
+
+        struct output
+        {
+            writer write;
+            void* device;
+        } outputs[256];
+};
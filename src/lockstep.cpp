@@ -0,0 +1,397 @@
+#include "lockstep.hpp"
+
+#include <cstring>
+
+#define REG_M 6 // Register number 6 is memory at HL
+#define REG_A 7
+#define NO_LANE 0x10000 // Above any PC
+
+// Cycles for each opcode that can run as a SIMD step, 0 for the rest, the bytes of operand after it,
+// and whether it reads the byte at HL. These only write registers, the flags and PC, so stores and the stack stay
+// with each lane's I8080
+struct VectorTable
+{
+    uint8_t cycles[256];
+    uint8_t operands[256];
+    bool reads_m[256];
+
+    constexpr VectorTable() : cycles(), operands(), reads_m()
+    {
+        cycles[0x00] = 4; // NOP
+
+        for (int r = 0; r < 8; ++r)
+        {
+            cycles[0x86 | (r << 3)] = 7; // ADD ADC SUB SBB ANA XRA ORA CMP M
+            reads_m[0x86 | (r << 3)] = true;
+
+            cycles[0xC6 | (r << 3)] = 7; // ADI ACI SUI SBI ANI XRI ORI CPI d8
+            operands[0xC6 | (r << 3)] = 1;
+            cycles[0xC2 | (r << 3)] = 10; // JNZ JZ JNC JC JPO JPE JP JM a16
+            operands[0xC2 | (r << 3)] = 2;
+
+            if (r == REG_M) continue;
+            cycles[0x04 | (r << 3)] = 5; // INR r
+            cycles[0x05 | (r << 3)] = 5; // DCR r
+            cycles[0x06 | (r << 3)] = 7; // MVI r, d8
+            operands[0x06 | (r << 3)] = 1;
+            cycles[0x46 | (r << 3)] = 7; // MOV r, M
+            reads_m[0x46 | (r << 3)] = true;
+            cycles[0x80 | r] = cycles[0x88 | r] = cycles[0x90 | r] = cycles[0x98 | r] = 4; // ADD ADC SUB SBB r
+            cycles[0xA0 | r] = cycles[0xA8 | r] = cycles[0xB0 | r] = cycles[0xB8 | r] = 4; // ANA XRA ORA CMP r
+
+            for (int s = 0; s < 8; ++s)
+                if (s != REG_M) cycles[0x40 | (r << 3) | s] = 5; // MOV r, s
+        }
+
+        cycles[0xC3] = 10; // JMP a16
+        operands[0xC3] = 2;
+    }
+};
+
+static constexpr VectorTable VECTOR;
+
+// Sign, zero and parity worked out arithmetically, a table lookup per lane wouldn't vectorise
+static inline uint8_t szp(uint8_t x)
+{
+    uint8_t p = x ^ (x >> 4);
+    p ^= p >> 2;
+    p ^= p >> 1;
+    return (x & FLAG_S) | (x == 0 ? FLAG_Z : 0) | ((~p & 1) << 2);
+}
+
+// Blend the new value into the lanes in the mask and keep the old one everywhere else
+static inline uint8_t select(uint8_t m, uint8_t value, uint8_t old)
+{
+    return (value & m) | (old & ~m);
+}
+
+// One ALU operation on A across every lane, op returns the result and sets the flags it produces
+template <bool write_a, typename Op>
+static void alu(int lanes, const uint8_t* m, uint8_t* a, uint8_t* psw, const uint8_t* value, Op op)
+{
+    for (int i = 0; i < lanes; ++i)
+    {
+        uint8_t flags;
+        uint8_t ans = op(a[i], value[i], psw[i], flags);
+        if (write_a) a[i] = select(m[i], ans, a[i]);
+        psw[i] = select(m[i] & FLAGS_ALL, flags, psw[i]);
+    }
+}
+
+Lockstep::Lockstep(int lanes) : lanes(lanes)
+{
+    for (int i = 0; i < lanes; ++i) cpus.emplace_back(new I8080());
+
+    for (std::vector<uint8_t>& r : regs) r.resize(lanes);
+    pc.resize(lanes);
+    sp.resize(lanes);
+    cycles.resize(lanes);
+    instructions.resize(lanes);
+    halted.resize(lanes);
+    in_cpu.assign(lanes, 1);
+    resident = lanes;
+    mask.resize(lanes);
+    low.resize(lanes);
+    high.resize(lanes);
+
+    for (int i = 0; i < lanes; ++i)
+    {
+        cpus[i]->init();
+        refresh(i, cpus[i]->core_state());
+    }
+}
+
+void Lockstep::load_rom(const char* filename)
+{
+    // Whole pages, so the last one is padded out with zeros
+    std::unique_ptr<uint8_t[]> image(new uint8_t[65536]());
+    size_t size = I8080::read_file(filename, image.get(), 65536);
+    rom_size = (size + MEMORY_PAGE_SIZE - 1) / MEMORY_PAGE_SIZE * MEMORY_PAGE_SIZE;
+    rom = std::move(image);
+
+    for (int i = 0; i < lanes; ++i)
+    {
+        to_cpu(i);
+        cpus[i]->map_rom(0x0000, rom_size, rom.get());
+        cpus[i]->init();
+        refresh(i, cpus[i]->core_state());
+    }
+
+    std::clog << "Loaded ROM into " << lanes << " lanes successfully!" << std::endl;
+}
+
+I8080::CoreState Lockstep::lane_state(int lane)
+{
+    to_cpu(lane);
+    return cpus[lane]->core_state();
+}
+
+void Lockstep::set_lane_state(int lane, const I8080::CoreState& core)
+{
+    to_cpu(lane);
+    cpus[lane]->restore(core);
+    refresh(lane, core);
+}
+
+void Lockstep::refresh(int lane, const I8080::CoreState& core)
+{
+    pc[lane] = core.registers.pc;
+    sp[lane] = core.registers.sp;
+    cycles[lane] = core.total_cycles;
+    instructions[lane] = core.instructions;
+    halted[lane] = core.halted;
+}
+
+void Lockstep::to_arrays(int lane)
+{
+    if (!in_cpu[lane]) return;
+
+    I8080::CPUState state = cpus[lane]->state();
+    regs[0][lane] = state.b;
+    regs[1][lane] = state.c;
+    regs[2][lane] = state.d;
+    regs[3][lane] = state.e;
+    regs[4][lane] = state.h;
+    regs[5][lane] = state.l;
+    regs[REG_M][lane] = state.psw;
+    regs[REG_A][lane] = state.a;
+    in_cpu[lane] = 0;
+    --resident;
+}
+
+void Lockstep::to_cpu(int lane)
+{
+    if (in_cpu[lane]) return;
+
+    // Interrupt state comes from the I8080 as it was, no SIMD step changes it but one can finish an EI
+    I8080::CoreState core = cpus[lane]->core_state();
+    if (core.ei_pending && core.instructions != instructions[lane])
+    {
+        core.inte = true;
+        core.ei_pending = false;
+    }
+    core.registers.b = regs[0][lane];
+    core.registers.c = regs[1][lane];
+    core.registers.d = regs[2][lane];
+    core.registers.e = regs[3][lane];
+    core.registers.h = regs[4][lane];
+    core.registers.l = regs[5][lane];
+    core.registers.psw = regs[REG_M][lane];
+    core.registers.a = regs[REG_A][lane];
+    core.registers.pc = pc[lane];
+    core.registers.sp = sp[lane];
+    core.total_cycles = cycles[lane];
+    core.instructions = instructions[lane];
+    cpus[lane]->restore(core);
+    in_cpu[lane] = 1;
+    ++resident;
+}
+
+void Lockstep::run(int budget)
+{
+    // Locals so the compiler knows stores to the byte arrays can't change them
+    int n = lanes;
+    const uint16_t* at = pc.data();
+    const uint64_t* cycle = cycles.data();
+    const uint8_t* halt = halted.data();
+    uint8_t* m = mask.data();
+
+    std::vector<uint64_t> end(n);
+    for (int i = 0; i < n; ++i) end[i] = cycle[i] + budget;
+
+    for (;;)
+    {
+        // Run the lowest PC any lane is at and the others wait, so lanes that split at a branch meet up again
+        // once the ones behind catch up, and lanes going round a loop again run ahead of those that left it
+        uint32_t lowest = NO_LANE;
+        for (int i = 0; i < n; ++i)
+        {
+            uint32_t here = cycle[i] < end[i] ? at[i] : NO_LANE;
+            lowest = here < lowest ? here : lowest;
+        }
+        if (lowest == NO_LANE) break;
+
+        uint16_t address = lowest;
+        int leader = 0;
+        while (cycle[leader] >= end[leader] || at[leader] != address) ++leader;
+        uint8_t opcode = cpus[leader]->read(address);
+        bool vector = VECTOR.cycles[opcode] != 0;
+
+        // The whole instruction is in the shared ROM, so every lane at the PC sees the same bytes
+        bool shared = (size_t) address + 2 < rom_size;
+
+        int group = 0;
+        for (int i = 0; i < n && vector; ++i)
+        {
+            bool same = cycle[i] < end[i] && at[i] == address && !halt[i];
+            if (same && !shared) same = cpus[i]->read(address) == opcode;
+            m[i] = same ? 0xFF : 0;
+            group += same;
+        }
+
+        // A group of one gains nothing from the arrays
+        if (vector && group > 1)
+        {
+            for (int i = 0; i < n && resident != 0; ++i)
+                if (m[i]) to_arrays(i);
+            vector_step(address, opcode, shared);
+            vectored += group;
+        }
+        else
+        {
+            // Lanes at the PC whose memory holds something else, or that are halted, step along with the group
+            for (int i = 0; i < n; ++i)
+                if (cycle[i] < end[i] && at[i] == address) scalar_step(i, end[i]);
+        }
+    }
+
+    for (int i = 0; i < n; ++i) to_cpu(i);
+}
+
+void Lockstep::scalar_step(int lane, uint64_t end)
+{
+    to_cpu(lane);
+
+    // A halted lane skips the rest of its budget in one go, the same as run_cycles
+    I8080& cpu = *cpus[lane];
+    cpu.run_cycles(halted[lane] ? (int) (end - cycles[lane]) : 1);
+    refresh(lane, cpu.core_state());
+    ++scalar;
+}
+
+void Lockstep::vector_step(uint16_t address, uint8_t opcode, bool shared)
+{
+    int n = lanes;
+    const uint8_t* m = mask.data();
+    uint8_t* a = regs[REG_A].data();
+    uint8_t* psw = regs[REG_M].data();
+    uint16_t* at = pc.data();
+    uint8_t* operand_low = low.data();
+    uint8_t* operand_high = high.data();
+    int r = (opcode >> 3) & 7;
+    const uint8_t* value = regs[opcode & 7].data();
+
+    // Operands in the shared ROM are the same for everyone, in RAM they come from each lane's own memory
+    int operands = VECTOR.operands[opcode];
+    if (operands != 0 && shared)
+    {
+        memset(operand_low, rom[address + 1], n);
+        memset(operand_high, rom[address + 2], n);
+    }
+    for (int i = 0; i < n && operands != 0 && !shared; ++i)
+    {
+        if (!m[i]) continue;
+        operand_low[i] = cpus[i]->read(at[i] + 1);
+        operand_high[i] = cpus[i]->read(at[i] + 2);
+    }
+    if (operands == 1) value = operand_low;
+
+    // Every lane reads its own memory at its own HL, which is a gather rather than SIMD but saves leaving the arrays
+    if (VECTOR.reads_m[opcode])
+    {
+        const uint8_t* h = regs[4].data();
+        const uint8_t* l = regs[5].data();
+        for (int i = 0; i < n; ++i)
+            if (m[i]) operand_low[i] = cpus[i]->read((h[i] << 8) | l[i]);
+        value = operand_low;
+    }
+
+    if ((opcode & 0xC0) == 0x80 || (opcode & 0xC7) == 0xC6) // ALU with a register, or with an immediate
+    {
+        switch (r)
+        {
+            case 0: // ADD
+            case 1: // ADC
+            {
+                bool with_carry = r == 1;
+                alu<true>(n, m, a, psw, value, [with_carry](uint8_t a, uint8_t v, uint8_t psw, uint8_t& flags)
+                {
+                    uint16_t ans = a + v + (with_carry ? psw & FLAG_C : 0);
+                    flags = szp((uint8_t) ans) | ((a ^ v ^ ans) & FLAG_AC) | (ans >> 8);
+                    return (uint8_t) ans;
+                });
+                break;
+            }
+            case 2: // SUB
+            case 3: // SBB
+            case 7: // CMP
+            {
+                bool with_borrow = r == 3;
+                auto sub = [with_borrow](uint8_t a, uint8_t v, uint8_t psw, uint8_t& flags)
+                {
+                    uint16_t ans = a - v - (with_borrow ? psw & FLAG_C : 0);
+                    // AC is the inverse of the borrow out of bit 3, as in I8080::sub
+                    flags = szp((uint8_t) ans) | (~(a ^ v ^ ans) & FLAG_AC) | ((ans >> 8) & FLAG_C);
+                    return (uint8_t) ans;
+                };
+                if (r == 7) alu<false>(n, m, a, psw, value, sub);
+                else alu<true>(n, m, a, psw, value, sub);
+                break;
+            }
+            case 4: // ANA
+                alu<true>(n, m, a, psw, value, [](uint8_t a, uint8_t v, uint8_t, uint8_t& flags)
+                {
+                    uint8_t ans = a & v;
+                    flags = szp(ans) | (((a | v) << 1) & FLAG_AC);
+                    return ans;
+                });
+                break;
+            case 5: // XRA
+                alu<true>(n, m, a, psw, value, [](uint8_t a, uint8_t v, uint8_t, uint8_t& flags)
+                {
+                    flags = szp(a ^ v);
+                    return (uint8_t) (a ^ v);
+                });
+                break;
+            case 6: // ORA
+                alu<true>(n, m, a, psw, value, [](uint8_t a, uint8_t v, uint8_t, uint8_t& flags)
+                {
+                    flags = szp(a | v);
+                    return (uint8_t) (a | v);
+                });
+                break;
+        }
+    }
+    else if (opcode >= 0xC2) // JMP and the conditional jumps, which take the same cycles either way
+    {
+        static const uint8_t CONDITION_FLAG[4] = { FLAG_Z, FLAG_C, FLAG_P, FLAG_S };
+        uint8_t flag = opcode == 0xC3 ? 0 : CONDITION_FLAG[r >> 1];
+        uint8_t when = r & 1 ? flag : 0; // Jump when the flag is set for odd conditions, clear for even ones
+
+        for (int i = 0; i < n; ++i)
+        {
+            uint16_t next = (psw[i] & flag) == when ? (operand_high[i] << 8) | operand_low[i] : at[i] + 3;
+            at[i] = m[i] ? next : at[i];
+        }
+    }
+    else if (opcode >= 0x40 || (opcode & 0x07) == 0x06) // MOV r, s and MVI r, d8
+    {
+        uint8_t* target = regs[r].data();
+        for (int i = 0; i < n; ++i) target[i] = select(m[i], value[i], target[i]);
+    }
+    else if (opcode != 0x00) // INR r and DCR r, which leave carry alone
+    {
+        uint8_t* target = regs[r].data();
+        uint8_t step = opcode & 1 ? 0xFF : 0x01;
+        uint8_t half = opcode & 1 ? 0x0F : 0x00; // Low nibble that clears AC after a decrement, or sets it after an increment
+        bool increment = !(opcode & 1);
+        for (int i = 0; i < n; ++i)
+        {
+            uint8_t ans = target[i] + step;
+            bool ac = ((ans & 0x0F) == half) == increment;
+            target[i] = select(m[i], ans, target[i]);
+            psw[i] = select(m[i] & (FLAGS_ALL & ~FLAG_C), szp(ans) | (ac ? FLAG_AC : 0), psw[i]);
+        }
+    }
+
+    uint8_t taken = VECTOR.cycles[opcode];
+    uint8_t length = operands == 2 ? 0 : 1 + operands; // Jumps have set PC already
+    uint64_t* cycle = cycles.data();
+    uint64_t* count = instructions.data();
+    for (int i = 0; i < n; ++i)
+    {
+        at[i] += m[i] & length;
+        cycle[i] += m[i] & taken;
+        count[i] += m[i] & 1;
+    }
+}
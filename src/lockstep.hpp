@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "i8080.hpp"
+
+// Experimental: runs many CPUs on the same program with their registers stored as parallel arrays, one entry per lane
+// Each step picks the lowest PC of any lane, and when that is an ALU, MOV, MVI or jump instruction, which write nothing
+// but registers, flags and PC, it runs for every lane at that PC at once, as one loop over the arrays the compiler can
+// turn into SIMD. Every other instruction falls back to running on each lane's own I8080, with the state moved across
+// through core_state and restore. Lanes elsewhere wait, so lanes that split at a branch line up again later
+class Lockstep
+{
+    public:
+        Lockstep(int lanes);
+
+        // Read a ROM image once and map it read-only at 0x0000 in every lane, the rest of memory is RAM
+        // Every lane running code from the ROM lets a SIMD step skip checking each lane's own copy of the instruction
+        void load_rom(const char* filename);
+        const uint8_t* rom_image() const { return rom.get(); }
+        size_t rom_bytes() const { return rom_size; } // Mapped size, a whole number of pages
+
+        // Run every lane until it has run at least budget more cycles, lanes finish exactly as run_cycles would
+        void run(int budget);
+
+        int size() const { return lanes; }
+
+        // A lane's state, kept in sync with the arrays, and its memory through the I8080 that runs it
+        I8080::CoreState lane_state(int lane);
+        void set_lane_state(int lane, const I8080::CoreState& core);
+        const I8080& lane(int lane) const { return *cpus[lane]; }
+
+        // Lane instructions run together as SIMD, and one lane at a time
+        uint64_t vector_instructions() const { return vectored; }
+        uint64_t scalar_instructions() const { return scalar; }
+
+    private:
+        int lanes;
+        std::vector<std::unique_ptr<I8080>> cpus;
+        std::unique_ptr<uint8_t[]> rom;
+        size_t rom_size = 0;
+
+        // By 8080 register number B C D E H L - A, slot 6 (M) holds the PSW instead
+        std::vector<uint8_t> regs[8];
+        std::vector<uint16_t> pc;
+        std::vector<uint16_t> sp;
+        std::vector<uint64_t> cycles;
+        std::vector<uint64_t> instructions;
+        std::vector<uint8_t> halted;
+        std::vector<uint8_t> in_cpu; // 1 while a lane's registers live in its I8080 rather than the arrays
+        int resident; // Lanes with in_cpu set
+        std::vector<uint8_t> mask; // 0xFF for the lanes in the current SIMD step, 0 for the rest
+        std::vector<uint8_t> low, high; // Operand bytes of the current SIMD step
+
+        uint64_t vectored = 0;
+        uint64_t scalar = 0;
+
+        void to_arrays(int lane); // Move a lane's registers out of its I8080
+        void to_cpu(int lane); // And back again
+        void refresh(int lane, const I8080::CoreState& core); // Copy PC, SP, counters and halt state from the I8080
+        void vector_step(uint16_t address, uint8_t opcode, bool shared); // shared when the instruction is in ROM
+        void scalar_step(int lane, uint64_t end);
+};
@@ -1,33 +1,69 @@
-#include <iostream>
 #include <chrono>
-#include <thread>
+#include <cstdlib>
+#include <iostream>
+#include <cstring>
+#include <memory>
 
-#include "i8080.hpp"
+#include "exit_hooks.hpp"
+#include "frame_writer.hpp"
+#include "invaders.hpp"
+#include "pacer.hpp"
 
 int main(int argc, char** argv)
 {
-    if (argc != 2)
+    const char* rom = NULL;
+    bool unthrottled = false;
+    bool headless = false; // No display, run at full speed
+    long dump_every = 0; // Save every Nth frame as an image, 0 for none
+    long frame_limit = 0; // Quit after this many frames, 0 to run forever
+    bool usage = argc < 2;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--unthrottled") == 0) unthrottled = true;
+        else if (strcmp(argv[i], "--headless") == 0) headless = true;
+        else if (strncmp(argv[i], "--dump-frames=", 14) == 0) dump_every = atol(argv[i] + 14);
+        else if (strncmp(argv[i], "--frames=", 9) == 0) frame_limit = atol(argv[i] + 9);
+        else if (rom == NULL && argv[i][0] != '-') rom = argv[i];
+        else usage = true;
+    }
+
+    if (usage || rom == NULL || dump_every < 0 || frame_limit < 0)
     {
-        std::cerr << "Usage: invaders <ROM>" << std::endl;
+        std::cerr << "Usage: invaders <ROM> [--unthrottled] [--headless] [--dump-frames=N] [--frames=N]" << std::endl;
         return 6;
     }
 
-    I8080 i8080 = I8080();
+    std::unique_ptr<Invaders> invaders(new Invaders());
+    std::unique_ptr<FrameWriter> writer(new FrameWriter());
 
     // Attempt to laod ROM
-    load:
-        i8080.load_rom(argv[1]);
+    invaders->load_rom(rom);
+
+    Pacer pacer(!unthrottled && !headless);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t cycles = 0;
 
-    // Emulation loop
-    while (true)
+    // Emulation loop, in trace and profile builds Ctrl+C ends it so the trace and report are written on the way out
+    while ((frame_limit == 0 || invaders->frames < (uint64_t) frame_limit) && exit_signal() == 0)
     {
-        i8080.run_opcode();
-        std::this_thread::sleep_for(std::chrono::nanoseconds((1 / CLOCK_SPEED) * 1000000000) * i8080.cycles); // Sleep to slow emulation time
-        if (i8080.total_cycles >= (CLOCK_SPEED / FPS) / 2) 
+        uint64_t frame = invaders->frames;
+
+        // Run up to the next interrupt then wait for real time to catch up
+        int ran = invaders->step();
+        cycles += ran;
+        pacer.wait(ran);
+
+        // Dirty scanlines pile up between renders, so only the frames being saved need converting
+        if (dump_every != 0 && invaders->frames != frame && invaders->frames % dump_every == 0)
         {
-            if (i8080.last_interrupt != 0x0008) i8080.generate_interrupt(0x0008);
-            else i8080.generate_interrupt(0x0010);
-            i8080.total_cycles = 0;
+            invaders->render();
+            if (!writer->write(*invaders->video, invaders->frames)) return 7;
         }
     }
-}
\ No newline at end of file
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::clog << "Ran " << invaders->frames << " frames in " << seconds << " seconds (" << invaders->frames / seconds
+        << " fps, " << cycles / seconds / 1e6 << " emulated MHz)" << std::endl;
+    return exit_signal() != 0 ? 128 + exit_signal() : 0;
+}
@@ -0,0 +1,35 @@
+#include "pacer.hpp"
+
+#include <thread>
+
+#include "i8080.hpp"
+
+#define MAX_LAG_CYCLES (CLOCK_SPEED / 10) // How far behind real time we can fall before giving up on catching up
+
+// A duration counted in CPU cycles, duration_cast does the conversion to host time without overflowing
+typedef std::chrono::duration<int64_t, std::ratio<1, CLOCK_SPEED>> cycle_time;
+
+Pacer::Pacer(bool throttled) : throttled(throttled), start(std::chrono::steady_clock::now())
+{
+}
+
+void Pacer::wait(int ran)
+{
+    if (!throttled) return;
+
+    cycles += ran;
+
+    // Deadlines are worked out from the total so rounding and oversleeping never add up to drift
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(cycle_time(cycles));
+    auto now = std::chrono::steady_clock::now();
+
+    if (now - deadline > cycle_time(MAX_LAG_CYCLES))
+    {
+        // We're too far behind (stopped in a debugger, host too slow), so start again from now instead of running flat out to catch up
+        start = now;
+        cycles = 0;
+        return;
+    }
+
+    std::this_thread::sleep_until(deadline);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Keeps emulation running at CLOCK_SPEED by sleeping once per batch of cycles
+class Pacer
+{
+    public:
+        Pacer(bool throttled = true);
+
+        // Sleep until the real time for all cycles run so far has passed
+        void wait(int cycles);
+
+    private:
+        bool throttled; // Run as fast as possible when false
+        std::chrono::steady_clock::time_point start; // Real time when cycles was zero
+        int64_t cycles = 0; // Cycles run since start
+};
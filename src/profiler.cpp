@@ -0,0 +1,64 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "exit_hooks.hpp"
+#include "trace.hpp"
+
+static void report_at_exit(void* profiler)
+{
+    static_cast<Profiler*>(profiler)->report();
+}
+
+Profiler::Profiler()
+{
+    add_exit_hook(report_at_exit, this);
+
+    // Time an empty measurement so the report can show how much of each instruction is the timer itself
+    overhead = UINT64_MAX;
+    for (int i = 0; i < 1000; ++i)
+    {
+        uint64_t start = profile_ticks();
+        overhead = std::min(overhead, profile_ticks() - start);
+    }
+}
+
+Profiler::~Profiler()
+{
+    finish_exit_hook(report_at_exit, this);
+}
+
+void Profiler::report(FILE* out)
+{
+    uint64_t instructions = 0;
+    uint64_t ticks = 0;
+    int order[256];
+    for (int i = 0; i < 256; ++i)
+    {
+        order[i] = i;
+        instructions += counts[i];
+        ticks += total_ticks[i];
+    }
+    if (instructions == 0) return;
+
+    std::sort(order, order + 256, [this](int a, int b) { return counts[a] > counts[b]; });
+
+    fprintf(out, "Opcode profile: %llu instructions, %.2f ticks per instruction (timer overhead %llu ticks)\n",
+        (unsigned long long) instructions, (double) ticks / instructions, (unsigned long long) overhead);
+    fprintf(out, "%-4s %-12s %12s %7s %7s %10s  %s\n", "op", "mnemonic", "count", "count%", "ticks%", "avg ticks", "histogram (log2 ticks:count)");
+
+    for (int i = 0; i < 256 && counts[order[i]] != 0; ++i)
+    {
+        int op = order[i];
+        fprintf(out, "%02x   %-12s %12llu %6.2f%% %6.2f%% %10.2f ",
+            op, MNEMONICS[op] != NULL ? MNEMONICS[op] : "?", (unsigned long long) counts[op],
+            100.0 * counts[op] / instructions, 100.0 * total_ticks[op] / ticks, (double) total_ticks[op] / counts[op]);
+
+        for (int bucket = 0; bucket < PROFILE_BUCKETS; ++bucket)
+        {
+            if (histogram[op][bucket] != 0) fprintf(out, " %d:%llu", bucket, (unsigned long long) histogram[op][bucket]);
+        }
+        fprintf(out, "\n");
+    }
+}
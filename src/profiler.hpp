@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#else
+    #include <chrono>
+#endif
+
+#define PROFILE_BUCKETS 16 // Histogram buckets, bucket n counts instructions taking 2^n to 2^(n+1) ticks
+
+// Host time stamp used to time instructions, reference cycles where rdtsc is available and nanoseconds elsewhere
+inline uint64_t profile_ticks()
+{
+    #if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+    #else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    #endif
+}
+
+// Counts how often each opcode runs and how long the host takes for it, reported at exit
+class Profiler
+{
+    public:
+        Profiler();
+        ~Profiler();
+
+        void record(uint8_t opcode, uint64_t ticks)
+        {
+            int bucket = 63 - __builtin_clzll(ticks | 1);
+            if (bucket >= PROFILE_BUCKETS) bucket = PROFILE_BUCKETS - 1;
+
+            ++counts[opcode];
+            total_ticks[opcode] += ticks;
+            ++histogram[opcode][bucket];
+        }
+
+        // Print the opcodes sorted by how often they ran
+        void report(FILE* out = stderr);
+
+    private:
+        uint64_t counts[256] = {};
+        uint64_t total_ticks[256] = {};
+        uint64_t histogram[256][PROFILE_BUCKETS] = {};
+        uint64_t overhead; // Ticks measured for an empty instruction
+};
@@ -0,0 +1,94 @@
+#include "rewind.hpp"
+
+#include <cstring>
+
+Rewind::Rewind(int capacity) : ring(capacity), capacity(capacity)
+{
+}
+
+uint32_t Rewind::copy_page(const uint8_t* memory)
+{
+    uint32_t page;
+    if (!free_pages.empty())
+    {
+        page = free_pages.back();
+        free_pages.pop_back();
+    }
+    else
+    {
+        page = pages.size();
+        pages.emplace_back();
+        references.push_back(0);
+    }
+
+    memcpy(pages[page].bytes, memory, MEMORY_PAGE_SIZE);
+    references[page] = 1;
+    return page;
+}
+
+void Rewind::release(Snapshot& snapshot)
+{
+    for (int i = 0; i < MEMORY_PAGES; ++i)
+        if (snapshot.pages[i] != NO_PAGE && --references[snapshot.pages[i]] == 0) free_pages.push_back(snapshot.pages[i]);
+}
+
+void Rewind::record(Invaders& invaders)
+{
+    // The first snapshot has nothing to share with, and written_pages is all ones after a reset or load_state
+    uint64_t ram = invaders.cpu.ram_pages();
+    uint64_t written = count == 0 ? ram : invaders.cpu.written_pages();
+
+    // Build the snapshot before dropping the oldest one, which may be the one it shares pages with
+    Snapshot snapshot;
+    snapshot.core = invaders.cpu.core_state();
+    snapshot.board = invaders.board_state();
+
+    for (int i = 0; i < MEMORY_PAGES; ++i)
+    {
+        if (!(ram & (1ULL << i))) snapshot.pages[i] = NO_PAGE;
+        else if (written & (1ULL << i)) snapshot.pages[i] = copy_page(invaders.cpu.memory_at(i * MEMORY_PAGE_SIZE));
+        else
+        {
+            snapshot.pages[i] = newest().pages[i];
+            ++references[snapshot.pages[i]];
+        }
+    }
+
+    if (count == capacity)
+    {
+        release(ring[oldest]);
+        oldest = (oldest + 1) % capacity;
+        --count;
+    }
+
+    ring[(oldest + count) % capacity] = snapshot;
+    ++count;
+    invaders.cpu.clear_written_pages();
+}
+
+bool Rewind::seek(Invaders& invaders, int frames_back)
+{
+    if (frames_back < 0 || frames_back >= count) return false;
+
+    // Memory matches the newest snapshot apart from the pages written since, so only pages that
+    // differ from it or were written need copying back
+    uint64_t written = invaders.cpu.written_pages();
+    uint32_t current[MEMORY_PAGES];
+    memcpy(current, newest().pages, sizeof(current));
+
+    for (; frames_back > 0; --frames_back)
+    {
+        release(newest());
+        --count;
+    }
+
+    Snapshot& snapshot = newest();
+    for (int i = 0; i < MEMORY_PAGES; ++i)
+        if (snapshot.pages[i] != NO_PAGE && ((written & (1ULL << i)) || snapshot.pages[i] != current[i]))
+            invaders.cpu.load(i * MEMORY_PAGE_SIZE, pages[snapshot.pages[i]].bytes, MEMORY_PAGE_SIZE);
+
+    invaders.cpu.restore(snapshot.core);
+    invaders.restore(snapshot.board);
+    invaders.cpu.clear_written_pages();
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "invaders.hpp"
+
+#define REWIND_FRAMES (60 * 60 * 5) // Five minutes at 60 frames a second
+#define NO_PAGE UINT32_MAX // Snapshot slot for a page that isn't RAM
+
+// Snapshots of the whole machine taken once a frame, to step back through recent play
+// Memory is kept in copy-on-write pages: a snapshot only copies the pages written since the one before
+// and shares every other page with it, so most frames cost a few KB instead of all of RAM
+// Only RAM pages are kept, ROM and mirrors never need saving
+class Rewind
+{
+    public:
+        Rewind(int capacity = REWIND_FRAMES);
+
+        // Take a snapshot, call once per frame, the oldest snapshot is dropped when full
+        void record(Invaders& invaders);
+
+        // Restore the snapshot taken frames_back records ago, 0 is the most recent
+        // Snapshots newer than it are dropped, returns false if there aren't that many
+        bool seek(Invaders& invaders, int frames_back);
+
+        int size() const { return count; } // Snapshots held
+        size_t page_bytes() const { return (pages.size() - free_pages.size()) * MEMORY_PAGE_SIZE; } // Page memory in use
+
+    private:
+        struct Snapshot
+        {
+            I8080::CoreState core;
+            Invaders::Board board;
+            uint32_t pages[MEMORY_PAGES]; // Index into pages for each page of RAM, NO_PAGE for the rest
+        };
+
+        struct Page
+        {
+            uint8_t bytes[MEMORY_PAGE_SIZE];
+        };
+
+        std::vector<Snapshot> ring;
+        int capacity;
+        int oldest = 0;
+        int count = 0;
+
+        std::deque<Page> pages; // Pool of page copies shared between snapshots, a deque so growing never copies them
+        std::vector<uint32_t> references; // Snapshots using each page
+        std::vector<uint32_t> free_pages;
+
+        uint32_t copy_page(const uint8_t* memory);
+        void release(Snapshot& snapshot);
+        Snapshot& newest() { return ring[(oldest + count - 1) % capacity]; }
+};
@@ -0,0 +1,24 @@
+#include "scheduler.hpp"
+
+void Scheduler::schedule(uint64_t when, callback fire, void* context)
+{
+    events.push({ when, scheduled++, fire, context });
+}
+
+void Scheduler::reset(uint64_t now)
+{
+    events = decltype(events)();
+    time = now;
+}
+
+void Scheduler::advance_to(uint64_t now)
+{
+    time = now;
+
+    while (!events.empty() && events.top().when <= time)
+    {
+        event due = events.top();
+        events.pop();
+        due.fire(due.context, due.when);
+    }
+}
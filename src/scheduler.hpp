@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+// Fires events at exact emulated cycle counts, such as the screen interrupts or device timers
+// Time is an absolute count of cycles since power on, so cycles run past a deadline are never lost
+class Scheduler
+{
+    public:
+        // Called with the cycle the event was scheduled for, which may be slightly before now
+        typedef void (*callback)(void* context, uint64_t when);
+
+        void schedule(uint64_t when, callback fire, void* context);
+
+        // Move time forward to now, firing every event that is due in deadline order
+        void advance_to(uint64_t now);
+        // Drop every pending event and set the time, used when restoring a saved state
+        void reset(uint64_t now);
+
+        uint64_t now() const { return time; }
+        uint64_t next() const { return events.empty() ? UINT64_MAX : events.top().when; } // Deadline of the next event
+
+    private:
+        struct event
+        {
+            uint64_t when;
+            uint64_t order; // Keeps events with the same deadline in the order they were scheduled
+            callback fire;
+            void* context;
+
+            bool operator>(const event& other) const
+            {
+                return when != other.when ? when > other.when : order > other.order;
+            }
+        };
+
+        std::priority_queue<event, std::vector<event>, std::greater<event>> events;
+        uint64_t time = 0;
+        uint64_t scheduled = 0; // Number of events ever scheduled
+};
@@ -0,0 +1,25 @@
+#include "shift_register.hpp"
+
+void ShiftRegister::attach(IOBus& bus)
+{
+    bus.map_out(SHIFT_OFFSET_PORT, write_offset, this);
+    bus.map_in(SHIFT_RESULT_PORT, read_result, this);
+    bus.map_out(SHIFT_DATA_PORT, write_data, this);
+}
+
+uint8_t ShiftRegister::read_result(void* device, uint8_t)
+{
+    ShiftRegister* shift = (ShiftRegister*) device;
+    return shift->value >> (8 - shift->offset);
+}
+
+void ShiftRegister::write_offset(void* device, uint8_t, uint8_t value)
+{
+    ((ShiftRegister*) device)->offset = value & 0x07;
+}
+
+void ShiftRegister::write_data(void* device, uint8_t, uint8_t value)
+{
+    ShiftRegister* shift = (ShiftRegister*) device;
+    shift->value = (value << 8) | (shift->value >> 8);
+}
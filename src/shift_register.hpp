@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+#include "io.hpp"
+
+#define SHIFT_OFFSET_PORT 2 // OUT: Bits 0-2 set how far the result is shifted
+#define SHIFT_RESULT_PORT 3 // IN: Byte read from the register at the current offset
+#define SHIFT_DATA_PORT 4 // OUT: Shift a new byte into the top of the register
+
+// The 16-bit shift register on the Space Invaders board, the 8080 has no barrel shifter of its own
+class ShiftRegister
+{
+    public:
+        void attach(IOBus& bus);
+
+    private:
+        uint16_t value = 0;
+        uint8_t offset = 0;
+
+        static uint8_t read_result(void* device, uint8_t port);
+        static void write_offset(void* device, uint8_t port, uint8_t value);
+        static void write_data(void* device, uint8_t port, uint8_t value);
+};
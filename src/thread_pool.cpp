@@ -0,0 +1,56 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(int threads) : threads(threads < 1 ? 1 : threads), shards(new shard[threads < 1 ? 1 : threads])
+{
+    for (int id = 1; id < this->threads; ++id) workers.emplace_back(&ThreadPool::worker, this, id);
+}
+
+ThreadPool::~ThreadPool()
+{
+    stopping.store(true);
+    generation.fetch_add(1, std::memory_order_release);
+    for (std::thread& thread : workers) thread.join();
+}
+
+void ThreadPool::run(int count, job fire, void* context)
+{
+    this->fire = fire;
+    this->context = context;
+    for (int id = 0; id < threads; ++id)
+    {
+        shards[id].next.store((int) ((int64_t) count * id / threads), std::memory_order_relaxed);
+        shards[id].end = (int) ((int64_t) count * (id + 1) / threads);
+    }
+
+    busy.store(threads - 1, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+
+    work(0);
+    while (busy.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+}
+
+void ThreadPool::worker(int id)
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        // Spin rather than sleep so a new job starts straight away
+        uint64_t current;
+        while ((current = generation.load(std::memory_order_acquire)) == seen) std::this_thread::yield();
+        seen = current;
+        if (stopping.load()) return;
+
+        work(id);
+        busy.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void ThreadPool::work(int id)
+{
+    // Own share first, then the others in turn starting with the next thread along
+    for (int i = 0; i < threads; ++i)
+    {
+        shard& victim = shards[(id + i) % threads];
+        for (int index; (index = victim.next.fetch_add(1, std::memory_order_relaxed)) < victim.end;) fire(context, index);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Runs a job over a range of indices on every core
+// Each thread starts on its own share of the range and steals from the other shares once its own runs out,
+// so uneven work still finishes together. Taking and stealing are single atomic adds, nothing ever locks
+class ThreadPool
+{
+    public:
+        typedef void (*job)(void* context, int index);
+
+        // The calling thread works too, so threads includes it
+        ThreadPool(int threads = std::thread::hardware_concurrency());
+        ~ThreadPool();
+
+        // Call fire(context, i) for every i in [0, count), returns once all of them have finished
+        void run(int count, job fire, void* context);
+
+        int size() const { return threads; }
+
+    private:
+        // Each share on its own cache line so threads taking work don't slow each other down
+        struct alignas(64) shard
+        {
+            std::atomic<int> next;
+            int end;
+        };
+
+        int threads;
+        std::vector<std::thread> workers;
+        std::unique_ptr<shard[]> shards;
+
+        job fire = nullptr;
+        void* context = nullptr;
+        std::atomic<uint64_t> generation{0}; // Bumped to hand the workers a new job
+        std::atomic<int> busy{0}; // Workers still on the current job
+        std::atomic<bool> stopping{false};
+
+        void worker(int id);
+        void work(int id); // Run the current job until every share is empty
+};
@@ -0,0 +1,80 @@
+#include "trace.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "exit_hooks.hpp"
+
+const char* const MNEMONICS[256] = {
+    "NOP", "LXI B, d16", "STAX B", "INX B", "INR B", "DCR B", "MVI B, d8", "RLC", // 0x00
+    NULL, "DAD B", "LDAX B", "DCX B", "INR C", "DCR C", "MVI C, d8", "RRC", // 0x08
+    NULL, "LXI D, 16", "STAX D", "INX D", "INR D", "DCR D", "MVI D, d8", "RAL", // 0x10
+    NULL, "DAD D", "LDAX D", "DCX D", "INR E", "DCR E", "MVI E, d8", "RAR", // 0x18
+    NULL, "LXI H, d16", "SHLD a16", "INX H", "INR H", "DCR H", "MVI H, d8", "DAA", // 0x20
+    NULL, "DAD H", "LHLD a16", "DCX H", "INR L", "DCR L", "MVI L, d8", "CMA", // 0x28
+    NULL, "LXI SP, d16", "STA a16", "INX SP", "INR M", "DCR M", "MVI M, d8", "STC", // 0x30
+    NULL, "DAD SP", "LDA a16", "DCX SP", "INR A", "DCR A", "MVI A, d8", "CMC", // 0x38
+    "MOV B, B", "MOV B, C", "MOV B, D", "MOV B, E", "MOV B, H", "MOV B, L", "MOV B, M", "MOV B, A", // 0x40
+    "MOV C, B", "MOV C, C", "MOV C, D", "MOV C, E", "MOV C, H", "MOV C, L", "MOV C, M", "MOV C, A", // 0x48
+    "MOV D, B", "MOV D, C", "MOV D, D", "MOV D, E", "MOV D, H", "MOV D, L", "MOV D, M", "MOV D, A", // 0x50
+    "MOV E, B", "MOV E, C", "MOV E, D", "MOV E, E", "MOV E, H", "MOV E, L", "MOV E, M", "MOV E, A", // 0x58
+    "MOV H, B", "MOV H, C", "MOV H, D", "MOV H, E", "MOV H, H", "MOV H, L", "MOV H, M", "MOV H, A", // 0x60
+    "MOV L, B", "MOV L, C", "MOV L, D", "MOV L, E", "MOV L, H", "MOV L, L", "MOV L, M", "MOV L, A", // 0x68
+    "MOV M, B", "MOV M, C", "MOV M, D", "MOV M, E", "MOV M, H", "MOV M, L", "HLT", "MOV M, A", // 0x70
+    "MOV A, B", "MOV A, C", "MOV A, D", "MOV A, E", "MOV A, H", "MOV A, L", "MOV A, M", "MOV A, A", // 0x78
+    "ADD B", "ADD C", "ADD D", "ADD E", "ADD H", "ADD L", "ADD M", "ADD A", // 0x80
+    "ADC B", "ADC C", "ADC D", "ADC E", "ADC H", "ADC L", "ADC M", "ADC A", // 0x88
+    "SUB B", "SUB C", "SUB D", "SUB E", "SUB H", "SUB L", "SUB M", "SUB A", // 0x90
+    "SBB B", "SBB C", "SBB D", "SBB E", "SBB H", "SBB L", "SBB M", "SBB H", // 0x98
+    "ANA B", "ANA C", "ANA D", "ANA E", "ANA H", "ANA L", "ANA M", "ANA A", // 0xA0
+    "XRA B", "XRA C", "XRA D", "XRA E", "XRA H", "XRA L", "XRA M", "XRA A", // 0xA8
+    "ORA B", "ORA C", "ORA D", "ORA E", "ORA H", "ORA L", "ORA M", "ORA A", // 0xB0
+    "CMP B", "CMP C", "CMP D", "CMP E", "CMP H", "CMP L", "CMP M", "CMP A", // 0xB8
+    "RNZ", "POP B", "JNZ a16", "JMP a16", "CNZ a16", "PUSH B", "ADI d8", "RST 0", // 0xC0
+    "RZ", "RET", "JZ a16", NULL, "CZ a16", "CALL a16", "ACI d8", "RST 1", // 0xC8
+    "RNC", "POP D", "JNC a16", "OUT d8", "CNC a16", "PUSH D", "SUI d8", "RST 2", // 0xD0
+    "RC", NULL, "JC a16", "IN d8", "CC a16", NULL, "SBI d8", "RST 3", // 0xD8
+    "RPO", "POP H", "JPO a16", "XTHL", "CPO a16", "PUSH H", "ANI d8", "RST 4", // 0xE0
+    "RPE", "PCHL", "JPE a16", "XCHG", "CPE a16", NULL, "XRA d8", "RST 5", // 0xE8
+    "RP", "POP PSW", "JP a16", "DI", "CP a16", "PUSH PSW", "ORI d8", "RST 6", // 0xF0
+    "RM", "SPHL", "JM a16", "EI", "CM a16", NULL, "CPI d8", "RST 7", // 0xF8
+};
+
+static void dump_at_exit(void* buffer)
+{
+    static_cast<TraceBuffer*>(buffer)->dump();
+}
+
+TraceBuffer::TraceBuffer() : records(TRACE_SIZE)
+{
+    add_exit_hook(dump_at_exit, this);
+}
+
+TraceBuffer::~TraceBuffer()
+{
+    finish_exit_hook(dump_at_exit, this);
+}
+
+void TraceBuffer::dump(const char* filename)
+{
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL)
+    {
+        std::cerr << "Couldn't open trace file: " << filename << std::endl;
+        return;
+    }
+
+    uint32_t count = head < TRACE_SIZE ? (uint32_t) head : TRACE_SIZE;
+    TraceHeader header = { { '8', '0', '8', '0' }, TRACE_VERSION, sizeof(TraceRecord), count };
+    fwrite(&header, sizeof(header), 1, file);
+
+    // Write the oldest part of the ring first so records come out in execution order
+    uint32_t start = (uint32_t) ((head - count) & (TRACE_SIZE - 1));
+    uint32_t first = count < TRACE_SIZE - start ? count : TRACE_SIZE - start;
+    fwrite(&records[start], sizeof(TraceRecord), first, file);
+    fwrite(&records[0], sizeof(TraceRecord), count - first, file);
+
+    fclose(file);
+    std::cerr << "Wrote " << count << " trace records to " << filename << std::endl;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#define TRACE_SIZE 65536 // Number of instructions kept in the ring buffer, must be a power of two
+#define TRACE_FILE "trace.bin" // File the trace is dumped to at exit
+#define TRACE_VERSION 1
+
+// CPU state captured right before an instruction is executed
+struct TraceRecord
+{
+    uint32_t cycles; // Low 32 bits of the CPU cycle count before this instruction
+    uint16_t pc;
+    uint16_t sp;
+    uint8_t opcode;
+    uint8_t operand; // Byte following the opcode
+    uint8_t a;
+    uint8_t b;
+    uint8_t c;
+    uint8_t d;
+    uint8_t e;
+    uint8_t h;
+    uint8_t l;
+    uint8_t psw; // Flags packed in the 8080 PSW layout
+};
+
+// Header written at the start of a trace file, followed by the records oldest first
+struct TraceHeader
+{
+    char magic[4]; // "8080"
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t count;
+};
+
+// Mnemonic logged for each opcode, NULL for unimplemented instructions
+extern const char* const MNEMONICS[256];
+
+class TraceBuffer
+{
+    public:
+        TraceBuffer();
+        ~TraceBuffer();
+
+        // Claim the slot for the next instruction, overwriting the oldest one when full
+        TraceRecord& next() { return records[head++ & (TRACE_SIZE - 1)]; }
+
+        void dump(const char* filename = TRACE_FILE);
+
+    private:
+        std::vector<TraceRecord> records;
+        uint64_t head = 0; // Total number of instructions recorded
+};
@@ -0,0 +1,86 @@
+#include <cstring>
+
+#include "video.hpp"
+
+// The 8 pixels drawn by each byte, low bit first
+struct ExpandTable
+{
+    uint32_t pixels[256][8];
+
+    constexpr ExpandTable() : pixels()
+    {
+        for (int x = 0; x < 256; ++x)
+            for (int bit = 0; bit < 8; ++bit)
+                pixels[x][bit] = (x >> bit) & 1 ? PIXEL_ON : PIXEL_OFF;
+    }
+};
+
+// Computed at compile time and shared by every Video
+static constexpr ExpandTable EXPAND;
+
+Video::Video()
+{
+    memset(pixels, 0, sizeof(pixels));
+}
+
+// Transposes the 8x8 bit matrix held in x, bit c of byte r becomes bit r of byte c
+static inline uint64_t transpose8(uint64_t x)
+{
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+void Video::convert(const uint8_t* vram)
+{
+    for (int line = 0; line < VRAM_ROWS; line += 8) convert_block(vram, line);
+}
+
+int Video::update(const uint8_t* vram, const uint8_t* dirty)
+{
+    int converted = 0;
+    for (int block = 0; block < VRAM_ROWS / 8; ++block)
+    {
+        if (dirty[block])
+        {
+            convert_block(vram, block * 8);
+            converted += 8;
+        }
+    }
+    return converted;
+}
+
+void Video::convert_block(const uint8_t* vram, int line)
+{
+    // Each scanline of the raster becomes a screen column, so 8 neighbouring scanlines give
+    // 8 bytes that transpose into 8 screen rows of 8 pixels each
+    for (int column = 0; column < VRAM_ROW_BYTES; ++column)
+    {
+        uint64_t block = 0;
+        for (int i = 0; i < 8; ++i)
+            block |= (uint64_t) vram[(line + i) * VRAM_ROW_BYTES + column] << (i * 8);
+        block = transpose8(block);
+
+        // Bit 0 of a byte is the bottom pixel of its column
+        uint32_t* row = pixels + (SCREEN_HEIGHT - 1 - column * 8) * SCREEN_WIDTH + line;
+        for (int bit = 0; bit < 8; ++bit, row -= SCREEN_WIDTH)
+            memcpy(row, EXPAND.pixels[(block >> (bit * 8)) & 0xFF], 8 * sizeof(uint32_t));
+    }
+}
+
+void Video::convert_scalar(const uint8_t* vram)
+{
+    for (int line = 0; line < VRAM_ROWS; ++line)
+    {
+        for (int y = 0; y < SCREEN_HEIGHT; ++y)
+        {
+            uint8_t byte = vram[line * VRAM_ROW_BYTES + y / 8];
+            pixels[(SCREEN_HEIGHT - 1 - y) * SCREEN_WIDTH + line] = (byte >> (y % 8)) & 1 ? PIXEL_ON : PIXEL_OFF;
+        }
+    }
+}
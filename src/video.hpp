@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include "i8080.hpp"
+
+// The monitor is mounted rotated 90 degrees counterclockwise, so the picture is taller than it is wide
+#define SCREEN_WIDTH 224
+#define SCREEN_HEIGHT 256
+
+// RGBA in memory order, whatever the byte order of the host
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    #define PIXEL_ON 0xFFFFFFFF
+    #define PIXEL_OFF 0xFF000000
+#else
+    #define PIXEL_ON 0xFFFFFFFF
+    #define PIXEL_OFF 0x000000FF
+#endif
+
+// Turns the 1bpp video RAM into an upright RGBA image
+class Video
+{
+    public:
+        uint32_t pixels[SCREEN_WIDTH * SCREEN_HEIGHT]; // Top row first
+
+        Video();
+
+        // Converts 8x8 pixel blocks at a time, vram points at VRAM_START
+        void convert(const uint8_t* vram);
+        // One pixel at a time, gives exactly the same image as convert
+        void convert_scalar(const uint8_t* vram);
+        // Only converts the blocks of 8 scanlines with a bit set in dirty, returns the scanlines converted
+        int update(const uint8_t* vram, const uint8_t* dirty);
+
+    private:
+        void convert_block(const uint8_t* vram, int line); // Scanlines line to line + 7
+};
@@ -0,0 +1,83 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../src/frame_hash.hpp"
+#include "../src/invaders.hpp"
+#include "../src/thread_pool.hpp"
+
+// Runs many independent machines at once, each frame every machine advances by one frame,
+// with the machines shared out across a work-stealing thread pool
+// Run with `make batch && ./invaders-batch <ROM> [--machines=N] [--frames=N] [--threads=N]`
+
+#define DEFAULT_MACHINES 1024
+#define DEFAULT_FRAMES 600
+
+static void run_frame(void* context, int index)
+{
+    std::vector<std::unique_ptr<Invaders>>& machines = *(std::vector<std::unique_ptr<Invaders>>*) context;
+    machines[index]->run_frame();
+}
+
+int main(int argc, char** argv)
+{
+    const char* rom = NULL;
+    long machine_count = DEFAULT_MACHINES;
+    long frames = DEFAULT_FRAMES;
+    long threads = std::thread::hardware_concurrency(); // 0 when it can't tell, so fall back to 1 as ThreadPool does
+    if (threads < 1) threads = 1;
+    bool usage = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], "--machines=", 11) == 0) machine_count = atol(argv[i] + 11);
+        else if (strncmp(argv[i], "--frames=", 9) == 0) frames = atol(argv[i] + 9);
+        else if (strncmp(argv[i], "--threads=", 10) == 0) threads = atol(argv[i] + 10);
+        else if (rom == NULL && argv[i][0] != '-') rom = argv[i];
+        else usage = true;
+    }
+
+    if (usage || rom == NULL || machine_count <= 0 || frames <= 0 || threads <= 0)
+    {
+        std::cerr << "Usage: invaders-batch <ROM> [--machines=N] [--frames=N] [--threads=N]" << std::endl;
+        return 1;
+    }
+
+    // The ROM is read once and shared, each machine only has its own RAM
+    std::shared_ptr<const Invaders::RomImage> image = Invaders::read_rom(rom);
+    std::vector<std::unique_ptr<Invaders>> machines;
+    for (long i = 0; i < machine_count; ++i)
+    {
+        machines.emplace_back(new Invaders());
+        machines.back()->use_rom(image);
+    }
+
+    ThreadPool pool(threads);
+
+    auto start = std::chrono::steady_clock::now();
+    for (long frame = 0; frame < frames; ++frame) pool.run(machine_count, run_frame, &machines);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Machines running the same ROM with the same inputs have to end up identical, unless they share state
+    uint64_t hash = frame_hash(machines[0]->cpu);
+    long differing = 0;
+    for (long i = 1; i < machine_count; ++i)
+        if (frame_hash(machines[i]->cpu) != hash) ++differing;
+
+    uint64_t cycles = 0;
+    for (long i = 0; i < machine_count; ++i) cycles += machines[i]->cpu.cycle_count();
+
+    printf("%ld machines x %ld frames on %d threads in %.3f seconds\n", machine_count, frames, pool.size(), seconds);
+    printf("%.0f frames/s in total, %.1f frames/s per machine, %.1f emulated MHz in total\n",
+        machine_count * frames / seconds, frames / seconds, cycles / seconds / 1e6);
+    if (differing != 0)
+    {
+        printf("%ld machines ended up different from the first\n", differing);
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "../src/i8080.hpp"
+#include "../src/io.hpp"
+
+// Runs CP/M CPU test programs such as cpudiag, 8080PRE, TST8080 and 8080EXM
+// Each program is loaded at 0x100 like a .COM file, with just enough of CP/M for them to print their results
+// Run with `make i8080-test && ./i8080-test <COM>...`
+
+// The BDOS entry at 0x0005 jumps to a stub that traps to the host with an OUT, then returns
+// Tests read the jump target at 0x0006 as the top of usable memory, so the stub sits high up
+#define COM_ORIGIN 0x0100
+#define BDOS_ENTRY 0x0005
+#define BDOS_STUB 0xFF00
+#define BDOS_PORT 0xFE // OUT: C holds the BDOS function
+#define BOOT_PORT 0xFF // OUT: The program jumped to 0x0000 to go back to CP/M
+
+#define BDOS_PRINT_CHAR 2 // Print the character in E
+#define BDOS_PRINT_STRING 9 // Print from DE up to a '$'
+
+#define RUN_SLICE 1000000 // Cycles per call to run_cycles between checks for the end of the test
+#define DEFAULT_MAX_CYCLES 100000000000LL // 8080EXM needs about 23 billion
+
+// What a test program has done so far
+struct Console
+{
+    I8080* cpu;
+    std::string output; // Everything printed, checked for failure messages at the end
+    bool finished = false;
+    uint64_t cycles = 0; // Cycle count when the program finished, the CPU then idles on HLT
+};
+
+static void print(Console& console, char c)
+{
+    putchar(c);
+    console.output += c;
+}
+
+static void bdos(void* device, uint8_t, uint8_t)
+{
+    Console& console = *(Console*) device;
+    I8080::CPUState state = console.cpu->state();
+
+    if (state.c == BDOS_PRINT_CHAR) print(console, state.e);
+    else if (state.c == BDOS_PRINT_STRING)
+    {
+        for (uint16_t address = (state.d << 8) | state.e; console.cpu->read(address) != '$'; ++address)
+            print(console, console.cpu->read(address));
+    }
+    fflush(stdout);
+}
+
+static void boot(void* device, uint8_t, uint8_t)
+{
+    Console& console = *(Console*) device;
+    console.finished = true;
+    console.cycles = console.cpu->cycle_count();
+}
+
+// Returns true if the program finished without reporting an error
+static bool run(const char* filename, long long max_cycles)
+{
+    std::unique_ptr<I8080> cpu(new I8080());
+    Console console;
+    console.cpu = cpu.get();
+
+    IOBus bus;
+    bus.map_out(BDOS_PORT, bdos, &console);
+    bus.map_out(BOOT_PORT, boot, &console);
+    cpu->io = &bus;
+
+    cpu->load_rom(filename, COM_ORIGIN);
+
+    // Warm boot: OUT BOOT_PORT then HLT, with interrupts off the CPU stays halted
+    const uint8_t warm_boot[] = { 0xD3, BOOT_PORT, 0x76 };
+    const uint8_t bdos_entry[] = { 0xC3, BDOS_STUB & 0xFF, BDOS_STUB >> 8 }; // JMP BDOS_STUB
+    const uint8_t bdos_stub[] = { 0xD3, BDOS_PORT, 0xC9 }; // OUT BDOS_PORT, RET
+    cpu->load(0x0000, warm_boot, sizeof(warm_boot));
+    cpu->load(BDOS_ENTRY, bdos_entry, sizeof(bdos_entry));
+    cpu->load(BDOS_STUB, bdos_stub, sizeof(bdos_stub));
+
+    auto start = std::chrono::steady_clock::now();
+    while (!console.finished && cpu->cycle_count() < (uint64_t) max_cycles) cpu->run_cycles(RUN_SLICE);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t cycles = console.finished ? console.cycles : cpu->cycle_count();
+
+    // The suites print ERROR or FAILED when a check goes wrong but still run to the end
+    bool passed = console.finished && console.output.find("ERROR") == std::string::npos &&
+        console.output.find("FAILED") == std::string::npos;
+
+    printf("\n%s %s: %llu instructions, %llu cycles in %.2f seconds (%.1f emulated MHz)%s\n",
+        passed ? "PASS" : "FAIL", filename, (unsigned long long) cpu->instruction_count(),
+        (unsigned long long) cycles, seconds, cycles / seconds / 1e6,
+        console.finished ? "" : ", never returned to CP/M");
+    return passed;
+}
+
+int main(int argc, char** argv)
+{
+    long long max_cycles = DEFAULT_MAX_CYCLES;
+    int failed = 0, count = 0;
+
+    for (int i = 1; i < argc; ++i)
+        if (strncmp(argv[i], "--max-cycles=", 13) == 0) max_cycles = atoll(argv[i] + 13);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], "--", 2) == 0) continue;
+        if (!run(argv[i], max_cycles)) ++failed;
+        ++count;
+    }
+
+    if (count == 0)
+    {
+        std::cerr << "Usage: i8080-test [--max-cycles=N] <COM>..." << std::endl;
+        return 1;
+    }
+
+    printf("%d of %d passed\n", count - failed, count);
+    return failed == 0 ? 0 : 2;
+}
@@ -0,0 +1,107 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../src/frame_hash.hpp"
+#include "../src/input_script.hpp"
+#include "../src/invaders.hpp"
+
+// Runs a ROM for a number of frames and checks the hash of every frame against a golden file
+// Record the golden file once with --record, then rerun after any change to the CPU to find the first frame that differs
+// The golden file has one `<frame> <hash>` line per frame
+
+#define DEFAULT_FRAMES 3600 // One minute of emulated time
+
+int main(int argc, char** argv)
+{
+    const char* rom = NULL;
+    const char* golden = NULL;
+    const char* inputs = NULL;
+    long frames = DEFAULT_FRAMES;
+    bool record = false;
+    bool usage = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--record") == 0) record = true;
+        else if (strncmp(argv[i], "--frames=", 9) == 0) frames = atol(argv[i] + 9);
+        else if (strncmp(argv[i], "--inputs=", 9) == 0) inputs = argv[i] + 9;
+        else if (rom == NULL && argv[i][0] != '-') rom = argv[i];
+        else if (golden == NULL && argv[i][0] != '-') golden = argv[i];
+        else usage = true;
+    }
+
+    if (usage || golden == NULL || frames <= 0)
+    {
+        std::cerr << "Usage: invaders-regress <ROM> <GOLDEN> [--frames=N] [--inputs=SCRIPT] [--record]" << std::endl;
+        return 1;
+    }
+
+    InputScript script;
+    if (inputs != NULL && !script.load(inputs)) return 2;
+
+    // Load the expected hashes before running so a bad file fails straight away
+    std::vector<uint64_t> expected;
+    if (!record)
+    {
+        FILE* file = fopen(golden, "r");
+        if (file == NULL)
+        {
+            std::cerr << "Couldn't open golden file: " << golden << std::endl;
+            return 2;
+        }
+
+        unsigned long long frame, hash;
+        while (fscanf(file, "%llu %llx", &frame, &hash) == 2 && frame == expected.size() + 1) expected.push_back(hash);
+        fclose(file);
+
+        if (expected.size() < (size_t) frames)
+        {
+            std::cerr << "Golden file only has " << expected.size() << " frames" << std::endl;
+            return 2;
+        }
+    }
+
+    std::unique_ptr<Invaders> invaders(new Invaders());
+    invaders->load_rom(rom);
+
+    std::vector<uint64_t> hashes;
+    auto start = std::chrono::steady_clock::now();
+    while (invaders->frames < (uint64_t) frames)
+    {
+        script.apply(invaders->frames, invaders->controls);
+        invaders->run_frame();
+
+        uint64_t hash = frame_hash(invaders->cpu);
+        if (!record && hash != expected[hashes.size()])
+        {
+            printf("First difference at frame %llu: expected %016llx, got %016llx (pc %04x)\n",
+                (unsigned long long) invaders->frames, (unsigned long long) expected[hashes.size()],
+                (unsigned long long) hash, invaders->cpu.state().pc);
+            return 3;
+        }
+        hashes.push_back(hash);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (record)
+    {
+        FILE* file = fopen(golden, "w");
+        if (file == NULL)
+        {
+            std::cerr << "Couldn't open golden file: " << golden << std::endl;
+            return 2;
+        }
+        for (size_t i = 0; i < hashes.size(); ++i)
+            fprintf(file, "%llu %016llx\n", (unsigned long long) i + 1, (unsigned long long) hashes[i]);
+        fclose(file);
+
+        printf("Recorded %ld frames to %s in %.3f seconds\n", frames, golden, seconds);
+    }
+    else printf("All %ld frames match in %.3f seconds\n", frames, seconds);
+    return 0;
+}
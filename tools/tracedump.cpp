@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "../src/trace.hpp"
+
+// Decodes a binary trace written by a TRACE build into the text log the emulator used to print
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: tracedump <TRACE> [--cycles]" << std::endl;
+        return 1;
+    }
+
+    bool show_cycles = argc == 3 && strcmp(argv[2], "--cycles") == 0;
+
+    FILE* file = fopen(argv[1], "rb");
+    if (file == NULL)
+    {
+        std::cerr << "Couldn't open trace: " << argv[1] << std::endl;
+        return 2;
+    }
+
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, "8080", 4) != 0)
+    {
+        std::cerr << "Not a trace file" << std::endl;
+        return 3;
+    }
+    if (header.version != TRACE_VERSION || header.record_size != sizeof(TraceRecord))
+    {
+        std::cerr << "Unsupported trace version " << header.version << std::endl;
+        return 4;
+    }
+
+    TraceRecord r;
+    for (uint32_t i = 0; i < header.count && fread(&r, sizeof(r), 1, file) == 1; ++i)
+    {
+        printf("================================================\n");
+        printf("PC: %x | OP: %x\n", r.pc, r.opcode);
+        if (show_cycles) printf("CYCLES: %u\n", r.cycles);
+        printf("SP: %x\n", r.sp);
+        printf("A: %x\nB: %x\nC: %x\nD: %x\nE: %x\nH: %x\nL: %x\n", r.a, r.b, r.c, r.d, r.e, r.h, r.l);
+        printf("S: %x\nZ: %x\nP: %x\nC: %x\nAC: %x\n",
+            (r.psw >> 7) & 1, (r.psw >> 6) & 1, (r.psw >> 2) & 1, r.psw & 1, (r.psw >> 4) & 1);
+        if (MNEMONICS[r.opcode] != NULL) printf("%s\n", MNEMONICS[r.opcode]);
+        if (r.opcode == 0x3E) printf("%x\n", r.operand); // MVI A also logged its operand
+    }
+
+    fclose(file);
+    return 0;
+}